@@ -13,6 +13,10 @@
 
 #include "include/bitboard.h"
 
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
 class LookUpTable
 {
 public:
@@ -22,9 +26,21 @@ public:
   bitboard get_king_attacks(int sq) const;
   bitboard get_pawn_attacks(int sq, bool white_side) const;
   bitboard get_pawn_pushes(int sq, bool white) const;
-  bitboard get_rook_attacks(int sq, bitboard blockers) const;
-  bitboard get_bishop_attacks(int sq, bitboard blockers) const;
-  bitboard get_queen_attacks(int sq, bitboard blockers) const;
+
+  static inline bitboard get_rook_attacks(int sq, bitboard blockers)
+  {
+    return rook_magics[sq].attacks[rook_magics[sq].index(blockers)];
+  }
+
+  static inline bitboard get_bishop_attacks(int sq, bitboard blockers)
+  {
+    return bishop_magics[sq].attacks[bishop_magics[sq].index(blockers)];
+  }
+
+  static inline bitboard get_queen_attacks(int sq, bitboard blockers)
+  {
+    return get_rook_attacks(sq, blockers) | get_bishop_attacks(sq, blockers);
+  }
 
   bitboard get_ray_from_bishop_to_king(int bishop_sq, int king_sq) const;
   bitboard get_ray_from_rook_to_king(int rook_sq, int king_sq) const;
@@ -32,15 +48,60 @@ public:
   bitboard get_ray_from_sq_to_sq(int start_sq, int target_sq) const;
 
   bitboard get_rank_mask(int rank) const;
-  
+
+  /// @brief squares strictly between a and b, empty unless they share a rank, file or diagonal
+  static inline bitboard get_between(int a, int b)
+  {
+    return between_table[a][b];
+  }
+
+  /// @brief the whole rank, file or diagonal through a and b (edge to edge), empty unless they share one
+  static inline bitboard get_line(int a, int b)
+  {
+    return line_table[a][b];
+  }
+
 
 private:
+  /**
+   * @brief Fancy magic entry for a single square. The relevant blockers are hashed into an
+   * index in a shared attack table, either with a multiply and shift or with pext when built
+   * with USE_PEXT (needs BMI2).
+   */
+  struct Magic
+  {
+    bitboard mask;
+    bitboard magic;
+    bitboard* attacks;
+    unsigned int shift;
+
+    inline unsigned int index(bitboard blockers) const
+    {
+#if defined(USE_PEXT)
+      return _pext_u64(blockers, mask);
+#else
+      return ((blockers & mask) * magic) >> shift;
+#endif
+    }
+  };
+
+  /* the slider tables don't depend on anything, so they are built once and shared by every lut */
+  static void init_slider_attacks();
+  static void init_magics(Magic magics[64], bitboard table[], const int directions[4][2]);
+
+  static inline Magic rook_magics[64];
+  static inline Magic bishop_magics[64];
+  static inline bitboard rook_table[0x19000]; // sum of 2^(relevant blockers) over every square
+  static inline bitboard bishop_table[0x1480];
+
+  static void init_lines();
+  static inline bitboard between_table[64][64];
+  static inline bitboard line_table[64][64];
+
   bitboard clear_rank[8];
   bitboard mask_rank[8];
   bitboard clear_file[8];
   bitboard mask_file[8];
-  bitboard mask_diagonal[15]; // only 15 diagonals, 8th is for alignment
-  bitboard mask_antidiagonal[15];
   bitboard pieces[64];
 
   bitboard king_attacks[64]; 
@@ -49,9 +110,4 @@ private:
   bitboard white_pawn_pushes[64];
   bitboard black_pawn_pushes[64];
   bitboard knight_attacks[64];
-
-  bitboard rank_attacks[64][256]; 
-  bitboard file_attacks[64][256];
-  bitboard diagonal_attacks[64][256]; // a1 to h8 diagonal
-  bitboard antidiagonal_attacks[64][256]; // a8 to h1 diagonal
 };
\ No newline at end of file
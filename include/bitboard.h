@@ -16,81 +16,10 @@
 #include "include/constants.h"
 
 #define REMOVE_FIRST(a) ((a) = ((a) & ((a)-1)))
-#define BIT_FROM_SQ(a) ((bitboard)0x1 << a) // replace all luts.pieces with this
+#define BIT_FROM_SQ(a) ((bitboard)0x1 << (a)) // replace all luts.pieces with this
 
 typedef long long unsigned int bitboard;
 
-inline bitboard rotate_right(bitboard b, int s) {return (b >> s) | (b << (64 - s));}
-
-inline bitboard flip_vertical(bitboard b) {
-  return  ((b << 56)                               ) |
-      ((b << 40) & bitboard(0x00ff000000000000)) |
-      ((b << 24) & bitboard(0x0000ff0000000000)) |
-      ((b <<  8) & bitboard(0x000000ff00000000)) |
-      ((b >>  8) & bitboard(0x00000000ff000000)) |
-      ((b >> 24) & bitboard(0x0000000000ff0000)) |
-      ((b >> 40) & bitboard(0x000000000000ff00)) |
-      ((b >> 56));
-}
-
-inline bitboard flip_diag_a1_h8(bitboard b) {
-  bitboard t;
-  const bitboard k1 = bitboard(0x5500550055005500);
-  const bitboard k2 = bitboard(0x3333000033330000);
-  const bitboard k4 = bitboard(0x0F0F0F0F00000000);
-  t = k4 & (b ^ (b << 28));
-  b ^= t ^ (t >> 28);
-  t = k2 & (b ^ (b << 14));
-  b ^= t ^ (t >> 14);
-  t = k1 & (b ^ (b << 7));
-  b ^= t ^ (t >> 7);
-  return b;
-}
-
-inline bitboard rotate_90_clockwise(bitboard b) {
-  return flip_vertical(flip_diag_a1_h8(b));
-}
-
-inline bitboard rotate_90_anticlockwise(bitboard b) {
-  return flip_diag_a1_h8(flip_vertical(b));
-}
-
-inline bitboard pseudo_rotate_45_clockwise(bitboard b) {
-  const bitboard k1 = bitboard(0xAAAAAAAAAAAAAAAA);
-  const bitboard k2 = bitboard(0xCCCCCCCCCCCCCCCC);
-  const bitboard k4 = bitboard(0xF0F0F0F0F0F0F0F0);
-  
-  b ^= k1 & (b ^ rotate_right(b, 8));
-  b ^= k2 & (b ^ rotate_right(b, 16));
-  b ^= k4 & (b ^ rotate_right(b, 32));
-  return b;
-}
-
-inline bitboard pseudo_rotate_45_anticlockwise(bitboard b) {
-  const bitboard k1 = bitboard(0x5555555555555555);
-  const bitboard k2 = bitboard(0x3333333333333333);
-  const bitboard k4 = bitboard(0x0F0F0F0F0F0F0F0F);
-  
-  b ^= k1 & (b ^ rotate_right(b, 8));
-  b ^= k2 & (b ^ rotate_right(b, 16));
-  b ^= k4 & (b ^ rotate_right(b, 32));
-  return b;
-}
-
-inline bitboard undo_pseudo_rotate_45_clockwise(bitboard b) {
-  for (size_t i = 0; i < 7; i++) {
-    b = pseudo_rotate_45_clockwise(b);
-  }
-  return b;
-}
-
-inline bitboard undo_pseudo_rotate_45_anticlockwise(bitboard b) {
-  for (size_t i = 0; i < 7; i++) {
-    b = pseudo_rotate_45_anticlockwise(b);
-  }
-  return b;
-}
-
 inline bitboard rem_first_bit(bitboard bits) {
   return bits & (bits - 1);
 }
@@ -109,4 +38,26 @@ inline int pop_count(bitboard b) {
 
 inline uint16_t first_set_bit(bitboard bits) {
   return constants::index64[((bits ^ (bits-1)) * constants::debruijn64) >> 58];
-}
\ No newline at end of file
+}
+
+constexpr bitboard FILE_A_BB = 0x0101010101010101;
+constexpr bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr bitboard RANK_1_BB = 0xFF;
+
+constexpr bitboard rank_bb(int rank) {
+  return RANK_1_BB << (8 * rank);
+}
+
+/**
+ * @brief Moves every bit on the board by the same square offset at once. Diagonal offsets drop
+ * the bits that would wrap around from one edge file to the other.
+ * @tparam Offset one of +-8, +-16 (along a file) or +-7, +-9 (diagonally)
+ */
+template <int Offset>
+constexpr bitboard shift(bitboard b) {
+  static_assert(Offset == 8 || Offset == -8 || Offset == 16 || Offset == -16 ||
+                Offset == 7 || Offset == -7 || Offset == 9 || Offset == -9, "not a pawn direction");
+  if constexpr (Offset == 9 || Offset == -7) b &= ~FILE_H_BB; // moving towards the h file
+  if constexpr (Offset == 7 || Offset == -9) b &= ~FILE_A_BB; // moving towards the a file
+  return (Offset > 0) ? (b << Offset) : (b >> -Offset);
+}
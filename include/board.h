@@ -21,6 +21,11 @@
 #include "include/move.h"
 #include "include/hashing.h"
 #include "include/utils.h"
+#include "include/attacks.h"
+
+class TranspositionTable;
+class EvalCache;
+class PawnTable;
 
 class Board
 {
@@ -85,9 +90,16 @@ public:
     return m_material_score;
   }
 
-  inline int get_positional_score() const
+  /// @brief material and piece-square score of both sides, from white's perspective
+  inline Score get_psq_score() const
+  {
+    return m_psq_score;
+  }
+
+  /// @brief MAX_PHASE with every piece on the board, 0 with only kings and pawns left
+  inline int get_phase() const
   {
-    return m_positional_score;
+    return m_phase;
   }
 
   inline int get_total_material() const
@@ -110,8 +122,21 @@ public:
     return m_pawn_hash;
   }
 
+  /**
+   * @brief Key of this position in the Polyglot book format. The piece part is kept up to date
+   * as pieces move, castling, en passant and side to move are folded in here.
+  */
+  uint64_t get_polyglot_key() const;
+
   bool is_repetition() const;
 
+  /**
+   * @brief Tables to prefetch from as soon as make_move knows the new keys, so the search's
+   * probes after the move don't stall on a cache miss. Any of them can be null. They aren't
+   * part of the position, copying a board copies the pointers along with it.
+  */
+  void set_prefetch_tables(const TranspositionTable* tt, const EvalCache* eval_cache, const PawnTable* pawn_table);
+
   inline bitboard get_piece_bitboard(piece pc) const
   {
     return m_piece_boards[utils::index_from_pc(pc)];
@@ -157,6 +182,35 @@ public:
     return m_irr_state_history.back().get_last_move();
   }
 
+  /// @brief move played plies_ago moves before the last one, Move::NO_MOVE past the start of the history
+  inline Move get_previous_move(size_t plies_ago) const
+  {
+    return (plies_ago < m_irr_state_history.size()) ? m_irr_state_history[m_irr_state_history.size() - 1 - plies_ago].get_last_move() : Move::NO_MOVE;
+  }
+
+  /// @brief pieces giving check to the side to move, computed once when the position is reached
+  inline bitboard get_checkers() const
+  {
+    return m_irr_state_history.back().get_checkers();
+  }
+
+  inline bool in_check() const
+  {
+    return get_checkers() != 0;
+  }
+
+  /// @brief pieces of either color that are the only piece between the side to move's king and an enemy slider
+  inline bitboard get_king_blockers() const
+  {
+    return m_irr_state_history.back().get_king_blockers();
+  }
+
+  /// @brief the side to move's pieces that are pinned to its king
+  inline bitboard get_pinned_pieces() const
+  {
+    return get_king_blockers() & (m_white_turn ? m_white_pieces : m_black_pieces);
+  }
+
   inline bitboard get_white_pieces() const
   {
     return m_white_pieces;
@@ -191,6 +245,9 @@ private:
    * Bits 11 - 14: last captured piece (0000 means EMPTY)
    * Bits 15 - 31: 50 move counter
    * Bits 32 - 63: move played to reach this position (used for recapture move ordering)
+   * 
+   * The checkers and king blockers aren't irreversible, but they are computed once per move and
+   * keeping them here means unmaking a move gets the old ones back for free.
    */
   class IrreversibleState
   {
@@ -243,8 +300,14 @@ private:
     inline void clr_last_move()               { m_state &= ~(constants::LAST_MOVE_MASK << constants::LAST_MOVE_OFFSET); }
     inline void set_last_move(Move last_move) { clr_last_move(); m_state |= (last_move.get_move() & constants::LAST_MOVE_MASK) << constants::LAST_MOVE_OFFSET; }
 
+    inline bitboard get_checkers() const      { return m_checkers; }
+    inline bitboard get_king_blockers() const { return m_king_blockers; }
+    inline void set_check_info(bitboard checkers, bitboard king_blockers) { m_checkers = checkers; m_king_blockers = king_blockers; }
+
   private:
     uint64_t m_state{};
+    bitboard m_checkers{};
+    bitboard m_king_blockers{};
   };
 
   /**
@@ -258,8 +321,18 @@ private:
   void place_piece(piece pc, int sq);
   void remove_piece(piece pc, int sq);
 
+  void prefetch(uint64_t board_hash, uint64_t pawn_hash) const;
+
+  /**
+   * @brief Finds the pieces checking the side to move and the pieces shielding its king from
+   * the enemy sliders, once the pieces and the side to move are up to date
+   * @param[out] state state of the new position to store them in
+  */
+  void update_check_info(IrreversibleState& state) const;
+
   /* private members */
   Hasher m_hasher;
+  LookUpTable m_lut;
 
   bitboard m_piece_boards[12];
   bitboard m_white_pieces;
@@ -277,10 +350,16 @@ private:
   uint64_t m_board_hash;
   uint64_t m_piece_hash;
   uint64_t m_pawn_hash;
+  uint64_t m_polyglot_piece_hash; // pieces only, see get_polyglot_key
+
+  const TranspositionTable* m_prefetch_tt = nullptr;
+  const EvalCache* m_prefetch_eval_cache = nullptr;
+  const PawnTable* m_prefetch_pawn_table = nullptr;
 
   /* evaluation items */
   int m_material_score;
-  int m_positional_score; // doesn't include kings
+  Score m_psq_score; // material and piece-square, both phases packed together
+  int m_phase;
   int m_piece_counts[10];
   int m_total_material;
 
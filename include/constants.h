@@ -2,6 +2,9 @@
 
 #include <string>
 #include <cmath>
+#include <array>
+
+#include "include/score.h"
 
 namespace constants
 {
@@ -49,6 +52,9 @@ inline int piece_values[10] = {100, // white pawn
                 900, // white queen
                -900};// black queen
 
+/* unsigned piece values for static exchange evaluation, indexed by PIECE(pc) >> 1 (EMPTY gives 0) */
+inline const int see_values[7] = {0, 100, 320, 330, 500, 900, 20000};
+
 inline int white_pawns_score[64] = 
 {
   0,   0,   0,   0,   0,   0,   0,  0,
@@ -239,10 +245,46 @@ inline int* piece_scores[14] =
   black_king_endgame_score
 };
 
-/// TODO: make these part of the parameterization 
-// this is also the number of entries... the real size is num_entries * sizeof(Entry)
-inline size_t SEARCH_TT_SIZE = std::pow(2, 26); 
-inline size_t EVAL_TT_SIZE = std::pow(2, 26); 
+/**
+ * @brief Material plus piece-square score for every piece on every square, with the middlegame
+ * and endgame halves packed together. Kings use their own middlegame and endgame tables, all the
+ * other pieces score the same in both phases.
+ */
+inline const std::array<std::array<Score, 64>, 12> psq_scores = []()
+{
+  std::array<std::array<Score, 64>, 12> scores{};
+  for (int index = 0; index < 12; index++)
+  {
+    for (int sq = 0; sq < 64; sq++)
+    {
+      if (index >= WHITE_KINGS_INDEX)
+      {
+        scores[index][sq] = make_score(piece_scores[index][sq], piece_scores[index + 2][sq]);
+      }
+      else
+      {
+        int value = piece_values[index] + piece_scores[index][sq];
+        scores[index][sq] = make_score(value, value);
+      }
+    }
+  }
+  return scores;
+}();
+
+/* how much each piece moves the game towards the middlegame, a full set of pieces is MAX_PHASE */
+inline int piece_phases[12] = {0, 0, 1, 1, 1, 1, 2, 2, 4, 4, 0, 0};
+inline int MAX_PHASE = 24;
+
+inline size_t MAX_THREADS = 512; // each thread has its own eval cache, pawn table and histories
+
+/* table sizes in megabytes, all of them can be changed with uci options */
+inline size_t HASH_MB = 64; // shared by every search thread
+inline size_t MAX_HASH_MB = 65536;
+inline size_t EVAL_CACHE_MB = 8; // per search thread
+inline size_t MAX_EVAL_CACHE_MB = 1024;
+inline size_t PAWN_HASH_MB = 1; // per search thread, pawn structures repeat a lot
+inline size_t MAX_PAWN_HASH_MB = 256;
+inline size_t PERFT_HASH_MB = 256; // shared by every perft thread, only allocated while perft runs
 
 inline int center_manhattan_distance_arr[64] = 
 {
@@ -261,6 +303,21 @@ inline int LAZY_EVAL_MARGIN = 200;
 inline int ATTACKING_WEIGHT = 15;
 inline int MOBILITY_WEIGHT = 1;
 
+/* pawn structure, each term is per pawn */
+inline Score DOUBLED_PAWN = make_score(-10, -20);
+inline Score ISOLATED_PAWN = make_score(-10, -15);
+inline Score BACKWARD_PAWN = make_score(-8, -10);
+inline Score passed_pawn_bonus[8] = // by rank from the pawn's own side
+{
+  make_score(0, 0), make_score(5, 10), make_score(10, 20), make_score(20, 40),
+  make_score(35, 70), make_score(60, 120), make_score(100, 200), make_score(0, 0)
+};
+
+/* king shield, per file in front of and next to the king */
+inline int SHIELD_PAWN_CLOSE = 12; // pawn right in front of the king
+inline int SHIELD_PAWN_FAR = 6; // pawn two ranks ahead
+inline int SHIELD_PAWN_MISSING = -10;
+
 inline static uint64_t EN_PASSANT_SQ_MASK = 0x7F;
 inline static uint16_t EN_PASSANT_OFFSET = 4;
 inline static uint64_t PIECE_MASK = 0xF;
@@ -285,6 +342,32 @@ inline int index64[64] = {
 
 inline const unsigned long long debruijn64 = 0x03f79d71b4cb0a89;
 
-inline const size_t KILLER_MAX_SIZE = 40; // defines the size of the killer move table 
+inline const int KILLER_MAX_SIZE = 40; // defines the size of the killer move table 
+inline const size_t NUM_KILLERS = 2; // killer slots per ply, the picker tries them before the other quiets
+inline const int HISTORY_MAX = 16384; // history scores approach but never pass this, fits in an int16_t
+inline const int HISTORY_BONUS_MAX = 2048; // largest single update from a cutoff
+inline const int HISTORY_ORDER_DIVISOR = 16; // scales the summed histories down into the quiet move ordering scores
+
+inline const int MAX_PLY = 128; // deepest line the pv table and seldepth keep track of
+
+/* aspiration windows, in centipawns */
+inline const int ASPIRATION_MIN_DEPTH = 5; // shallower iterations are cheap enough to search with a full window
+inline const int ASPIRATION_WINDOW = 75; // starting distance from the last score on each side, doubled on every re-search
+inline const int ASPIRATION_MAX_WINDOW = 1000; // beyond this give up and search with a full window
+
+/* selectivity, depths are in plies */
+inline const int QSEARCH_SEE_THRESHOLD = -50; // quiescence skips captures that lose more than this in the exchange
+inline const int LMR_MIN_DEPTH = 3; // late move reductions only kick in from this depth
+inline const int LMR_MIN_MOVES = 3; // the first moves of a node are always searched to full depth
+inline const int LMR_HISTORY_DIVISOR = 8192; // a history this good or bad shifts the reduction by a ply
+inline const int LMP_MAX_DEPTH = 3; // late move pruning only at this depth and below
+inline const int FUTILITY_MAX_DEPTH = 3; // futility pruning only at this depth and below
+inline const int futility_margins[FUTILITY_MAX_DEPTH + 1] = {0, 150, 300, 500}; // indexed by depth
+
+/* time management, all in milliseconds */
+inline const int MOVE_OVERHEAD = 30; // kept in reserve for gui and os lag 
+inline const int DEFAULT_MOVES_TO_GO = 30; // assumed number of moves left when the gui doesn't tell us
+inline const int MAX_MOVES_TO_GO = 50;
+inline const uint64_t TIME_CHECK_NODES = 1024; // how often the main thread looks at the clock
 
 }
\ No newline at end of file
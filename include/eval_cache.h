@@ -0,0 +1,71 @@
+/**
+ * @file eval_cache.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Cache of static evaluations
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+
+#include "include/large_pages.h"
+
+/**
+ * @brief Remembers exact static evaluations by position hash. Each entry is a single word: the
+ * upper 48 bits of the hash with the 16 bit score in the lower bits, so a probe is one load and
+ * a compare. Each search thread owns its evaluator, so the cache needs no locking.
+ */
+class EvalCache
+{
+public:
+  /// @brief sized in megabytes, the number of entries is rounded down to a power of two
+  EvalCache(size_t megabytes);
+
+  /**
+   * @brief Looks up the static eval of a position
+   * @param[in] hash full position hash
+   * @return the stored eval, from white's perspective
+  */
+  inline std::optional<int> probe(uint64_t hash) const
+  {
+    uint64_t entry = m_table[hash & m_mask];
+    if (((entry ^ hash) & KEY_MASK) == 0)
+    {
+      return static_cast<int16_t>(entry & SCORE_MASK);
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Stores the static eval of a position, always replacing what was there
+   * @param[in] hash full position hash
+   * @param[in] eval eval from white's perspective, has to fit in 16 bits
+  */
+  inline void store(uint64_t hash, int eval)
+  {
+    m_table[hash & m_mask] = (hash & KEY_MASK) | (static_cast<uint16_t>(eval) & SCORE_MASK);
+  }
+
+  /// @brief starts loading the entry for hash into cache, without waiting for it
+  inline void prefetch(uint64_t hash) const { __builtin_prefetch(&m_table[hash & m_mask]); }
+
+  void resize(size_t megabytes);
+  void clear();
+
+  inline LargePageBuffer::Mode get_page_mode() const { return m_memory.get_mode(); }
+
+private:
+  static constexpr uint64_t SCORE_MASK = 0xFFFF;
+  static constexpr uint64_t KEY_MASK = ~SCORE_MASK;
+
+  uint64_t* m_table;
+  LargePageBuffer m_memory;
+  size_t m_mask;
+};
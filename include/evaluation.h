@@ -13,29 +13,44 @@
 
 #include "include/board.h"
 #include "include/hashing.h"
-#include "include/tt.h"
+#include "include/eval_cache.h"
+#include "include/pawns.h"
+#include "include/score.h"
 #include "attacks.h"
 #include <climits>
 
 class Evaluator
 {
 public:
-  Evaluator(Board::Ptr m_board);
+  Evaluator(Board::Ptr m_board, size_t eval_cache_mb = constants::EVAL_CACHE_MB, size_t pawn_hash_mb = constants::PAWN_HASH_MB);
   ~Evaluator() {}
 
   int evaluate(int alpha, int beta);
 
   void clear_eval_table();
 
+  /**
+   * @brief Reallocates the eval cache and pawn table, throwing away what was in them
+   * @param[in] eval_cache_mb size of the eval cache in megabytes
+   * @param[in] pawn_hash_mb size of the pawn table in megabytes
+  */
+  void resize_tables(size_t eval_cache_mb, size_t pawn_hash_mb);
+
+  inline const EvalCache& get_eval_cache() const { return m_eval_cache; }
+  inline const PawnTable& get_pawn_table() const { return m_pawn_table; }
+
+  inline LargePageBuffer::Mode get_eval_cache_page_mode() const { return m_eval_cache.get_page_mode(); }
+  inline LargePageBuffer::Mode get_pawn_table_page_mode() const { return m_pawn_table.get_page_mode(); }
+
 private:
   Board::Ptr m_board;
   LookUpTable lut; // would like to not have to repeat this in the future
-  TranspositionTable m_table;
+  EvalCache m_eval_cache;
+  PawnTable m_pawn_table;
 
   bool sufficient_checkmating_material();
-  float calculate_game_phase();
   int mop_up_eval(bool white_winning);
-  int evaluate_pawns();
+  Score evaluate_pawns();
   int evaluate_knights(bitboard white_king_squares, bitboard black_king_squares);
   int evaluate_bishops(bitboard white_king_squares, bitboard black_king_squares);
   int evaluate_rooks(bitboard white_king_squares, bitboard black_king_squares);
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 #include "include/pieces.h"
 
@@ -33,6 +34,11 @@ public:
   uint64_t get_black_queen_side_hash() const;
   uint64_t get_en_passant_hash(int sq) const;
   uint64_t get_black_to_move_hash() const;
+
+  /// @brief xor of every key in the table, anything that stores hashes can use it to check they still match
+  uint64_t get_checksum() const;
+
+  static constexpr unsigned int ZOBRIST_SEED = 1234124;
 private:
   struct ZobristTable 
   {
@@ -45,4 +51,30 @@ private:
 
   uint64_t en_passant_file[8];
   } m_zobrist_table;
-};
\ No newline at end of file
+};
+
+/**
+ * @brief The Random64 table from the Polyglot book format, so we can compute the same keys as
+ * every other tool that reads .bin books. The 781 numbers are copied from the spec into
+ * hashing.cpp and checked at compile time against the spec's key for the starting position.
+ */
+class PolyglotHasher
+{
+public:
+  static constexpr size_t NUM_KEYS = 781;
+  static constexpr size_t CASTLE_OFFSET = 768;
+  static constexpr size_t EN_PASSANT_OFFSET = 772;
+  static constexpr size_t TURN_OFFSET = 780;
+
+  /* polyglot orders pieces black first (bp, wp, bn, wn, ...), we order them white first */
+  inline static uint64_t get_piece_key(piece pc, int sq) { return s_keys[64 * ((pc - 2) ^ 1) + sq]; }
+  inline static uint64_t get_castle_key(int i) { return s_keys[CASTLE_OFFSET + i]; } // 0: K, 1: Q, 2: k, 3: q
+  inline static uint64_t get_en_passant_key(int file) { return s_keys[EN_PASSANT_OFFSET + file]; }
+  inline static uint64_t get_white_to_move_key() { return s_keys[TURN_OFFSET]; }
+
+  /// @brief key of the starting position worked out from the table alone, used to check the table
+  static constexpr uint64_t start_position_key();
+
+private:
+  static const uint64_t s_keys[NUM_KEYS];
+};
@@ -0,0 +1,64 @@
+/**
+ * @file large_pages.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Huge page backed memory for the hash tables
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Owns a zeroed block of memory for a hash table. The tables are probed at random on every
+ * node, so backing them with 2 MB pages saves most of the TLB misses. Explicit huge pages
+ * (MAP_HUGETLB) are tried first, they need pages reserved in /proc/sys/vm/nr_hugepages. Otherwise
+ * the block is mapped normally and marked with MADV_HUGEPAGE so transparent huge pages can back it.
+ * Blocks smaller than a huge page always get normal pages rather than being rounded up to one.
+ */
+class LargePageBuffer
+{
+public:
+  enum class Mode { NONE, HUGETLB, TRANSPARENT, NORMAL, FILE };
+
+  LargePageBuffer() = default;
+  ~LargePageBuffer();
+
+  LargePageBuffer(const LargePageBuffer&) = delete;
+  LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+
+  /**
+   * @brief Frees the current block and maps a new zeroed one, exits if there isn't enough memory
+   * @param[in] bytes size of the block
+   * @return the block, aligned to at least a page
+  */
+  void* allocate(size_t bytes);
+
+  /**
+   * @brief Frees the current block and maps a file copy-on-write instead. Pages are read in as
+   * they are touched, and writes stay in memory and never reach the file.
+   * @param[in] fd open file, it can be closed once this returns
+   * @param[in] bytes size of the file
+   * @return start of the mapped file, or nullptr if it couldn't be mapped (the old block is kept)
+  */
+  void* map_file(int fd, size_t bytes);
+  void release();
+
+  inline void* get() const { return m_memory; }
+  inline size_t size() const { return m_size; }
+  inline Mode get_mode() const { return m_mode; }
+
+  static std::string mode_name(Mode mode);
+
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+private:
+  void* m_memory = nullptr;
+  size_t m_size = 0; // size of the mapping, which can be rounded up from what was asked for
+  Mode m_mode = Mode::NONE;
+};
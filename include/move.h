@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <algorithm>
 
 /**
  * @brief Representation for a move. The first 16 bits hold the from square, 
@@ -107,4 +108,48 @@ public:
 
 private:
   int m_move{};
-};
\ No newline at end of file
+};
+
+/**
+ * @brief Fixed capacity list of moves with inline storage, so generating moves never
+ * touches the heap. No legal position has more than 218 moves, so 256 is plenty.
+ */
+class MoveList
+{
+public:
+  static constexpr size_t MAX_MOVES = 256;
+
+  inline MoveList() : m_size{0} {} // the storage is deliberately left uninitialized
+
+  inline void push_back(Move move) { m_moves[m_size++] = move; }
+  inline void clear() { m_size = 0; }
+
+  inline size_t size() const { return m_size; }
+  inline bool empty() const { return m_size == 0; }
+
+  inline Move& operator[](size_t i) { return m_moves[i]; }
+  inline const Move& operator[](size_t i) const { return m_moves[i]; }
+
+  inline Move* begin() { return m_moves; }
+  inline Move* end() { return m_moves + m_size; }
+  inline const Move* begin() const { return m_moves; }
+  inline const Move* end() const { return m_moves + m_size; }
+
+  /**
+   * @brief Sorts the moves from highest to lowest score
+  */
+  inline void sort()
+  {
+    std::sort(begin(), end(), [](Move mv1, Move mv2) { return mv1.score() > mv2.score(); });
+  }
+
+  template <typename Compare>
+  inline void sort(Compare comp)
+  {
+    std::sort(begin(), end(), comp);
+  }
+
+private:
+  union { Move m_moves[MAX_MOVES]; };
+  size_t m_size;
+};
@@ -15,7 +15,8 @@
 #include <string>
 #include <array>
 #include <optional>
-#include <unordered_set>
+#include <cstdint>
+#include <cstdlib>
 
 #include "include/move.h"
 #include "include/board.h"
@@ -24,91 +25,218 @@
 class MoveGenerator
 {
 public:
-  MoveGenerator(Board::Ptr board);
+  /** 
+   * @brief Which subset of the legal moves to generate. EVASIONS are the moves out of check, asking
+   * for ALL while in check generates them too, and asking for them out of check gives ALL.
+   */
+  enum class GenType { ALL, CAPTURES, QUIETS, EVASIONS };
 
-  void generate_moves(std::vector<Move> &curr_moves, bool captures_only = false) const;
-  void order_moves(std::vector<Move> &moves, Move tt_best_move = Move::NO_MOVE, std::optional<int> ply_from_root = std::nullopt) const; /// TODO: fix this I don't like passing this in
+  MoveGenerator(Board::Ptr board);
 
-  inline void insert_killer(int ply_from_root, const Move& move)
+  void generate_moves(MoveList &curr_moves, GenType type = GenType::ALL) const;
+
+  /**
+   * @brief Checks if a move (usually from the transposition table) is legal in the current position
+   * @param[in] move move to check
+   * @return true if generate_moves would have generated this exact move 
+  */
+  bool is_legal(Move move) const;
+
+  /**
+   * @brief Gives each move its ordering score without sorting them
+   * @param[in, out] moves moves to score
+   * @param[in] ply_from_root used to look up killer moves
+  */
+  void score_moves(MoveList &moves, std::optional<int> ply_from_root = std::nullopt) const;
+  void order_moves(MoveList &moves, Move tt_best_move = Move::NO_MOVE, std::optional<int> ply_from_root = std::nullopt) const; /// TODO: fix this I don't like passing this in
+
+  /**
+   * @brief Remembers a quiet move that caused a cutoff at this ply, two per ply with the newest first
+   * @param[in] ply_from_root ply the cutoff happened at
+   * @param[in] move quiet move that caused it
+  */
+  inline void insert_killer(int ply_from_root, Move move)
   {
     if (ply_from_root >= constants::KILLER_MAX_SIZE)
     {
       return;
     }
-    int lookup = (move.get_move() & 0x0000FFFF) | ((*m_board)[move.from()] << 16); // insert the move and moving piece together 
-    m_killer_moves[ply_from_root].insert(lookup); // add the move and the moving piece 
+    auto& killers = m_killer_moves[ply_from_root];
+    if (!(killers[0] == move))
+    {
+      killers[1] = killers[0];
+      killers[0] = move;
+    }
+  }
+
+  /// @brief which killer slot the move is in at this ply, -1 if it isn't a killer
+  inline int killer_slot(int ply_from_root, Move move) const
+  {
+    if (ply_from_root >= constants::KILLER_MAX_SIZE)
+    {
+      return -1;
+    }
+    const auto& killers = m_killer_moves[ply_from_root];
+    return (killers[0] == move) ? 0 : (killers[1] == move) ? 1 : -1;
   }
 
-  inline bool is_killer(int ply_from_root, const Move& move) const
+  /// @brief the killer in the given slot at this ply, Move::NO_MOVE if there isn't one
+  inline Move get_killer(int ply_from_root, int slot) const
   {
     if (ply_from_root >= constants::KILLER_MAX_SIZE)
     {
-      return false;
+      return Move::NO_MOVE;
     }
-    int lookup = (move.get_move() & 0x0000FFFF) | ((*m_board)[move.from()] << 16); // look up the move and moving piece together
-    return m_killer_moves[ply_from_root].count(lookup); 
+    return m_killer_moves[ply_from_root][slot];
+  }
+
+  inline bool is_killer(int ply_from_root, Move move) const
+  {
+    return killer_slot(ply_from_root, move) >= 0;
   }
 
   inline void clear_killers()
   {
-    for (auto& set : m_killer_moves)
+    for (auto& killers : m_killer_moves)
     {
-      set.clear();
+      killers.fill(Move::NO_MOVE);
     }
   }
 
+  /**
+   * @brief Updates every quiet move heuristic after a quiet move causes a beta cutoff: the killers,
+   * the counter move, and the butterfly and continuation histories. The quiet moves searched before it
+   * failed to cut off, so they get the same amount taken away.
+   * @param[in] ply_from_root ply the cutoff happened at
+   * @param[in] best_move quiet move that caused the cutoff
+   * @param[in] quiets_tried quiet moves searched before it at this node
+   * @param[in] depth remaining depth of the node, deeper cutoffs count for more
+  */
+  void update_quiet_histories(int ply_from_root, Move best_move, const MoveList& quiets_tried, int depth);
+
+  /**
+   * @brief How good a quiet move has been so far: the butterfly history plus the continuation history
+   * following the last two moves played
+   * @param[in] move quiet move, with the board in the position it's played from
+  */
+  int get_history(Move move) const;
+
+  /// @brief halves every history score, so old searches count for less than recent ones
+  void age_history();
+
   std::string notation_from_move(Move move) const;
   Move move_from_notation(std::string notation) const;
   std::string move_to_long_algebraic(Move move) const;
   Move move_from_long_algebraic(std::string notation) const;
-  void sort_by_long_algebraic_notation(std::vector<Move>& moves) const;
-
-  int see(int sq) const;
-  int see_capture(Move capture) const;
-  bool is_bad_capture(Move capture) const;
+  void sort_by_long_algebraic_notation(MoveList& moves) const;
+
+  /**
+   * @brief Static exchange evaluation. Both sides keep recapturing on the move's to square with their
+   * least valuable attacker, sliders behind the pieces that leave the square joining in, and either side
+   * can stop when recapturing would lose material. Played out on bitboards, the board is never touched.
+   * @param[in] move move to evaluate, usually a capture
+   * @return material the mover comes out of the exchange with, in centipawns
+  */
+  int see(Move move) const;
+
+  /**
+   * @brief Whether see(move) >= threshold. Cheaper than see, most captures are decided by the first
+   * one or two pieces in the exchange.
+   * @param[in] move move to evaluate
+   * @param[in] threshold material the mover needs to come out with, in centipawns
+  */
+  bool see_ge(Move move, int threshold) const;
   bool pawn_promo_or_close_push(Move move) const;
 
-  bool in_check() const;
-
 private:
   Board::Ptr m_board;
   LookUpTable lut;
   // look up by ply, and also store the moving piece to ensure its the same move 
-  std::array<std::unordered_set<int>, constants::KILLER_MAX_SIZE> m_killer_moves;
+  std::array<std::array<Move, constants::NUM_KILLERS>, constants::KILLER_MAX_SIZE> m_killer_moves{};
+
+  /* history scores, all kept within +-HISTORY_MAX */
+  typedef std::array<std::array<int16_t, 64>, 12> PieceToHistory; // indexed by piece index and to square
+  int m_history[2][64][64] = {}; // butterfly history, indexed by side to move, from square and to square
+  std::vector<PieceToHistory> m_continuation_history; // one table per piece index and to square of an earlier move, 1.2 MB so it lives on the heap
+  Move m_counter_moves[12][64] = {}; // quiet move that last refuted the previous move, by its piece index and to square
+
+  /**
+   * @brief What move ordering needs to know about the current position, looked up once per node
+   * instead of once per move
+   */
+  struct OrderingContext
+  {
+    int recapture_square;
+    std::optional<int> ply_from_root; // only set for quiet moves in the main search, enables the quiet heuristics
+    Move counter_move;
+    const PieceToHistory* continuations[2]; // following the last move and the move before it, nullptr if there was none
+  };
 
+  OrderingContext get_ordering_context(std::optional<int> ply_from_root) const;
 
-  struct Pin
+  /**
+   * @brief Index of the continuation history table following a move played plies_ago before the last one
+   * @return index into m_continuation_history, or -1 after a null move or at the start of the game
+  */
+  int get_continuation_index(size_t plies_ago) const;
+
+  inline static void update_gravity(int& entry, int bonus)
   {
-    bitboard ray_at_sq[64];
-    bitboard pinned_pieces{};
-  };
+    /* the closer the entry is to the limit, the less it moves towards it */
+    entry += bonus - entry * abs(bonus) / constants::HISTORY_MAX;
+  }
 
-  enum class CheckType { NONE, SINGLE, DOUBLE };
 
-  Pin get_pinned_pieces(int friendly_king_loc) const;
+  enum class CheckType { NONE, SINGLE, DOUBLE };
 
-  bitboard checking_pieces() const;
   CheckType check_type(bitboard checkers) const;
+  bitboard get_check_mask(bitboard checkers) const;
+
+  int get_recapture_square() const;
+  int score_move(Move mv, const OrderingContext& context) const;
 
-  bitboard generate_knight_move_bitboard(int knight_sq, bool captures_only = false) const;
-  bitboard generate_king_move_bitboard(int king_sq, bool captures_only = false) const;
-  bitboard generate_pawn_move_bitboard(int pawn_sq, bool captures_only = false) const;
-  bitboard generate_rook_move_bitboard(int rook_sq, bool captures_only = false) const;
-  bitboard generate_bishop_move_bitboard(int bishop_sq, bool captures_only = false) const;
-  bitboard generate_queen_move_bitboard(int queen_sq, bool captures_only = false) const;
+  /*
+    Generation is templated on the side to move (Us) and the generation type, and generate_moves picks
+    the instantiation once at the top. Everything below it then knows the colors, pawn directions and
+    targets at compile time, so there are no color or type branches left inside the per piece loops.
+    The templates are only instantiated in move_gen.cpp, so they are defined there.
+  */
+  template <piece Us, GenType Type>
+  void generate(MoveList &curr_moves, bitboard checkers) const;
 
-  void generate_king_moves(std::vector<Move> &curr_moves, bool captures_only = false) const;
-  void generate_knight_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only = false) const;
-  void generate_pawn_moves(std::vector<Move> &curr_moves, bitboard check_mask, bool pawn_check, Pin &pin, bool captures_only = false) const;
-  void generate_rook_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only = false) const;
-  void generate_bishop_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only = false) const;
-  void generate_queen_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only = false) const;
+  template <piece Us, GenType Type>
+  bitboard generate_king_move_bitboard(int king_sq) const;
+  template <piece Us, GenType Type>
+  bitboard generate_pawn_move_bitboard(int pawn_sq) const;
+
+  template <piece Us, GenType Type>
+  void generate_king_moves(MoveList &curr_moves) const;
+  template <piece Us, GenType Type>
+  void generate_pawn_moves(MoveList &curr_moves, bitboard check_mask, bool pawn_check, bitboard pinned) const;
+
+  /// @brief whether taking en passant from a pawn on from leaves the king attacked along its rank
+  template <piece Us>
+  bool en_passant_uncovers_king(int from, int en_passant_sq) const;
+
+  /// @brief knights, bishops, rooks and queens, which only differ in how they attack
+  template <piece Us, piece Pc, GenType Type>
+  void generate_piece_moves(MoveList &curr_moves, bitboard check_mask, bitboard pinned) const;
+
+  template <piece Pc>
+  bitboard piece_attacks(int sq, bitboard occupied) const;
+
+  /// @brief squares a piece other than a pawn may move to for this generation type, before check and pins
+  template <piece Us, GenType Type>
+  bitboard target_squares() const;
+
+  template <piece Color>
+  inline bitboard pieces_of() const { return (Color == WHITE) ? m_board->get_white_pieces() : m_board->get_black_pieces(); }
 
   bitboard generate_attack_map(bool white_side) const;
-  piece least_valued_attacker(int sq) const;
-  int least_valued_attacker_sq(int sq, bool white_turn) const;
+  bitboard attackers_to(int sq, bitboard occupied) const; // of both colors, sliders blocked by occupied
   bool is_attacked_by_pawn(int sq) const;
+
+  /// @brief whether the side that isn't Us attacks sq, with sliders blocked by blockers
+  template <piece Us>
   bool is_attacked(int sq, bitboard blockers) const;
-  bitboard attackers_from_square(int sq) const;
-  bitboard opponent_slider_rays_to_square(int sq) const;
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+/**
+ * @file move_picker.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Hands out moves to the search one at a time, generating them in stages
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "include/move.h"
+#include "include/move_gen.h"
+
+#include <cstddef>
+
+/**
+ * @brief Staged, lazy move picker. Most nodes that cut off do so on the transposition table
+ * move or on one of the first captures, so rather than generating and sorting every move up front
+ * the picker only generates a stage once the previous one is exhausted, and pulls the best
+ * remaining move of a stage with a selection pass instead of a full sort.
+ *
+ * Main search order: tt move -> good captures -> killers -> quiets -> losing captures
+ * Quiescence order:  captures
+ */
+class MovePicker
+{
+public:
+  /**
+   * @brief Picker for the main search
+   * @param[in] move_gen move generator of the position being searched
+   * @param[in] tt_move move to try first, ignored if it isn't legal here
+   * @param[in] ply_from_root used to look up killer moves
+  */
+  MovePicker(const MoveGenerator& move_gen, Move tt_move, int ply_from_root);
+
+  /**
+   * @brief Picker for quiescence search, only hands out captures
+   * @param[in] move_gen move generator of the position being searched
+  */
+  MovePicker(const MoveGenerator& move_gen);
+
+  /**
+   * @brief Gets the next move to search
+   * @return the next move, or Move::NO_MOVE when there are no moves left
+  */
+  Move next_move();
+
+private:
+  enum class Stage
+  {
+    TT_MOVE,
+    GENERATE_CAPTURES,
+    GOOD_CAPTURES,
+    KILLERS,
+    GENERATE_QUIETS,
+    QUIETS,
+    BAD_CAPTURES,
+    QSEARCH_GENERATE_CAPTURES,
+    QSEARCH_CAPTURES,
+    DONE
+  };
+
+  const MoveGenerator& m_move_gen;
+  Move m_tt_move;
+  int m_ply_from_root;
+  Stage m_stage;
+
+  MoveList m_moves; // moves of the current stage
+  MoveList m_bad_captures; // losing captures, deferred until after the quiets
+  size_t m_index;
+
+  /**
+   * @brief Swaps the highest scoring move left in m_moves to m_index and returns it
+  */
+  Move select_best();
+};
@@ -1,13 +1,13 @@
 /**
  * @file openings.h
  * @author Jason Stentz (jstentz@andrew.cmu.edu)
- * @brief Outlines structures and functions for playing moves in the 
+ * @brief Outlines structures and functions for playing moves in the
  * opening phase of the game.
  * @version 0.1
  * @date 2022-06-08
- * 
+ *
  * @copyright Copyright (c) 2022
- * 
+ *
  */
 
 #pragma once
@@ -16,25 +16,103 @@
 #include "include/hashing.h"
 #include "include/board.h"
 
-#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include <string>
 #include <vector>
+#include <random>
 
-/// @brief this setup doesn't really make sense, I should redo this and make it faster
+/**
+ * @brief Read only opening book backed by a memory mapped file. The file is an array of
+ * fixed size entries sorted by zobrist key, so loading it is just an mmap (the pages are
+ * shared between every engine process using the same book) and a lookup is a binary search.
+ * 
+ * Two formats are understood, picked by file extension:
+ *  - .bin: Polyglot books, big endian entries keyed by the Polyglot zobrist keys
+ *  - anything else: our own compiled books, native entries keyed by Board::get_hash
+ */
 class OpeningBook
 {
 public:
-  /// @brief populates the opening book from binary text, can take a little bit of time
-  OpeningBook();
-  ~OpeningBook() {} 
+  /**
+   * @brief A single book move. Entries for the same position are adjacent in the file.
+   */
+  struct Entry
+  {
+    uint64_t key; // zobrist hash of the position
+    uint16_t move; // lower 16 bits of the Move
+    uint16_t weight; // how often the move was played, used for picking between moves
+    uint32_t reserved;
+  };
+  static_assert(sizeof(Entry) == 16, "book entries are read straight from the file");
+
+  /**
+   * @brief A Polyglot entry as it sits in the file, every field is big endian
+   */
+  struct PolyglotEntry
+  {
+    uint64_t key;
+    uint16_t move; // to file, to row, from file, from row, promotion piece; 3 bits each from the LSB
+    uint16_t weight;
+    uint32_t learn;
+  };
+  static_assert(sizeof(PolyglotEntry) == 16, "book entries are read straight from the file");
+
+  enum class Format { NATIVE, POLYGLOT };
 
+  /// @brief maps the book at path, an unreadable or missing file just gives an empty book
+  OpeningBook(const std::string& path = "assets/opening_book.cbook");
+  ~OpeningBook();
+
+  /**
+   * @brief Unmaps the current book and maps the one at path instead
+   * @param[in] path book to open, the format is picked from the extension
+   * @return true if the book was opened
+  */
+  bool open(const std::string& path);
+
+  /// @brief always play the most played book move instead of picking one weighted at random
+  inline void set_best_move_only(bool best_move_only) { m_best_move_only = best_move_only; }
+
+  OpeningBook(const OpeningBook&) = delete;
+  OpeningBook& operator=(const OpeningBook&) = delete;
+
+  /**
+   * @brief Picks a book move for the position, weighted by how often each move was played
+   * @param[in] board position to look up
+   * @return a book move, or Move::NO_MOVE if the position isn't in the book
+  */
   Move get_opening_move(Board::Ptr board);
 
-  /// @brief creates the opening book from the text file of lines 
-  // std::unordered_map<uint64_t, std::vector<Move>> create_opening_book() const;
+  inline bool is_loaded() const { return m_mapping != nullptr; }
+  inline Format get_format() const { return m_format; }
+  inline size_t size() const { return m_size; }
 
-  /// @brief converts the book to a file of numbers instead of moves
-  // void generate_binary_file();
+  /**
+   * @brief Compiles the old text dump (a hash followed by the moves played from it on each line,
+   * with repeated moves counting towards their weight) into the binary format
+   * @param[in] text_path text dump to read
+   * @param[in] book_path binary book to write
+   * @return number of entries written, 0 on failure
+  */
+  static size_t compile(const std::string& text_path, const std::string& book_path);
 
 private:
-  std::unordered_map<uint64_t, std::vector<Move>> m_opening_book;
-};
\ No newline at end of file
+  void* m_mapping;
+  size_t m_mapping_size;
+  size_t m_size; // number of entries
+  Format m_format;
+  bool m_best_move_only;
+  std::mt19937_64 m_rng;
+
+  void close();
+
+  /**
+   * @brief Chooses between the weights of the moves found for a position
+   * @return index into weights of the chosen move
+  */
+  size_t pick(const std::vector<uint16_t>& weights);
+
+  Move get_native_move(Board::Ptr board);
+  Move get_polyglot_move(Board::Ptr board);
+};
@@ -0,0 +1,85 @@
+/**
+ * @file pawns.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Pawn structure evaluation and the hash table that caches it
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include "include/board.h"
+#include "include/bitboard.h"
+#include "include/score.h"
+
+#include <cstdint>
+#include <cstddef>
+
+#include "include/large_pages.h"
+
+/**
+ * @brief Caches the pawn structure score of a position, keyed by the board's pawn hash. Pawns
+ * move rarely, so almost every probe is a hit and the structure terms come for free. Each search
+ * thread owns its own evaluator, so the table needs no locking.
+ *
+ * The king shield depends on the king square as well, so it is computed lazily and cached in the
+ * entry next to the square it was computed for.
+ */
+class PawnTable
+{
+public:
+  struct Entry
+  {
+    uint64_t key;
+    Score score; // doubled, isolated, backward and passed pawns, from white's perspective
+    Score shield[2]; // indexed by color, pawn shield of the king on king_sq, from that side's perspective
+    int8_t king_sq[2]; // constants::NONE until a shield is cached
+  };
+
+  /// @brief sized in megabytes, the number of entries is rounded down to a power of two
+  PawnTable(size_t megabytes);
+
+  /**
+   * @brief Finds the entry for the board's pawns, evaluating them on a miss
+   * @param[in] board position to look up
+   * @return the entry, valid until the next probe
+  */
+  Entry* probe(const Board& board);
+
+  /**
+   * @brief Shield score for a side's king, cached in the entry while the king stays put
+   * @param[in] entry entry returned by probe for this board
+   * @param[in] board position the entry was probed for
+   * @param[in] white side of the king
+   * @return shield score from white's perspective
+  */
+  Score get_king_shield(Entry* entry, const Board& board, bool white);
+
+  /// @brief starts loading the entry for a pawn hash into cache, without waiting for it
+  inline void prefetch(uint64_t pawn_hash) const { __builtin_prefetch(&m_table[pawn_hash & m_mask]); }
+
+  void resize(size_t megabytes);
+  void clear();
+
+  inline LargePageBuffer::Mode get_page_mode() const { return m_memory.get_mode(); }
+
+private:
+  Entry* m_table;
+  LargePageBuffer m_memory;
+  size_t m_mask;
+
+  bitboard m_file_masks[8];
+  bitboard m_adjacent_files[8];
+  /* indexed by color and square */
+  bitboard m_front_spans[2][64]; // squares in front of a pawn on its own file
+  bitboard m_passed_masks[2][64]; // squares an enemy pawn would need to stop a passer
+  bitboard m_support_masks[2][64]; // squares on adjacent files a defending pawn could come from
+  bitboard m_pawn_attacks[2][64];
+
+  Score evaluate(const Board& board);
+  Score evaluate_side(bitboard own_pawns, bitboard their_pawns, bool white);
+  Score evaluate_shield(bitboard own_pawns, int king_sq, bool white);
+};
@@ -0,0 +1,81 @@
+/**
+ * @file perft.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Hash table of subtree sizes shared by the perft threads
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <optional>
+
+#include "include/large_pages.h"
+
+/**
+ * @brief Remembers how many leaf nodes lie below a position at a given depth, so a subtree that
+ * is reached again by transposition is only counted once. Like the transposition table, every
+ * entry stores its key xor'd with its data, so any number of perft threads can probe and store
+ * without locks and a torn entry just fails the key check.
+ */
+class PerftTable
+{
+public:
+  /// @brief sized in megabytes, the number of entries is rounded down to a power of two
+  PerftTable(size_t megabytes);
+
+  /**
+   * @brief Looks up the size of a subtree
+   * @param[in] hash full position hash
+   * @param[in] depth depth the subtree was counted to
+   * @return the number of leaf nodes, if this position was stored at exactly this depth
+  */
+  inline std::optional<uint64_t> probe(uint64_t hash, int depth) const
+  {
+    const Entry& entry = m_table[hash & m_mask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t key = entry.key.load(std::memory_order_relaxed);
+    if ((key ^ data) == hash && static_cast<int>(data & DEPTH_MASK) == depth)
+    {
+      return data >> NODES_OFFSET;
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Stores the size of a subtree, always replacing what was there
+   * @param[in] hash full position hash
+   * @param[in] depth depth the subtree was counted to, has to fit in 8 bits
+   * @param[in] nodes number of leaf nodes, has to fit in 56 bits
+  */
+  inline void store(uint64_t hash, int depth, uint64_t nodes)
+  {
+    Entry& entry = m_table[hash & m_mask];
+    uint64_t data = (nodes << NODES_OFFSET) | (static_cast<uint64_t>(depth) & DEPTH_MASK);
+    entry.key.store(hash ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+  }
+
+  void resize(size_t megabytes);
+  void clear();
+
+private:
+  struct Entry
+  {
+    std::atomic<uint64_t> key; // hash ^ data
+    std::atomic<uint64_t> data; // leaf nodes above the depth in the lowest 8 bits
+  };
+
+  static constexpr uint64_t DEPTH_MASK = 0xFF;
+  static constexpr uint16_t NODES_OFFSET = 8;
+
+  Entry* m_table;
+  LargePageBuffer m_memory;
+  size_t m_mask;
+};
@@ -0,0 +1,37 @@
+/**
+ * @file score.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Middlegame and endgame scores packed into a single integer
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief A middlegame score in the lower 16 bits and an endgame score in the upper 16 bits.
+ * Adding or subtracting two packed scores adds or subtracts both halves at once, so the board
+ * can keep both phases up to date with a single add per piece.
+ */
+typedef int32_t Score;
+
+constexpr Score make_score(int mg, int eg)
+{
+  return static_cast<Score>(static_cast<uint32_t>(eg) << 16) + mg;
+}
+
+constexpr int mg_value(Score s)
+{
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s)));
+}
+
+constexpr int eg_value(Score s)
+{
+  /* the +0x8000 undoes the borrow a negative middlegame half takes from the endgame half */
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s + 0x8000) >> 16));
+}
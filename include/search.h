@@ -16,13 +16,103 @@
 #include "include/openings.h"
 #include "include/evaluation.h"
 #include "include/tt.h"
+#include "include/time_manager.h"
 
 #include <stddef.h>
 #include <cstdint>
+#include <climits>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
 
-// new class implementation
+/**
+ * @brief A single thread of the search. Each worker owns its own copy of the board,
+ * its own move generator (and therefore its own killer moves) and its own evaluator.
+ * Only the transposition table and the abort flag are shared between workers, which
+ * is what lets the helper threads speed up the main one (Lazy SMP).
+ */
+class SearchWorker
+{
+public:
+  using Ptr = std::shared_ptr<SearchWorker>;
+  using ConstPtr = std::shared_ptr<const SearchWorker>;
+
+  SearchWorker(int id, TranspositionTable& tt, TimeManager& time_manager, std::atomic<bool>& abort_search, 
+               const std::vector<Ptr>& workers, size_t eval_cache_mb, size_t pawn_hash_mb);
+
+  /**
+   * @brief Copies the given position into the worker's board and resets the per-search state
+   * @param[in] board position to search 
+  */
+  void set_position(const Board& board);
+
+  /**
+   * @brief Runs iterative deepening until max_depth is reached or the search is aborted
+   * @param[in] max_depth deepest iteration to search 
+  */
+  void iterative_deepening(int max_depth);
+
+  inline Move get_best_move() const { return m_best_move; }
+  inline int get_best_score() const { return m_best_score; }
+  inline int get_completed_depth() const { return m_completed_depth; }
+  inline uint64_t get_nodes() const { return m_nodes.load(std::memory_order_relaxed); }
+  inline Evaluator& get_evaluator() { return m_evaluator; }
+  inline const MoveGenerator& get_move_gen() const { return m_move_gen; } // on the worker's own board, back at the root after a search
+
+private:
+  int m_id;
+  Board::Ptr m_board;
+  MoveGenerator m_move_gen;
+  Evaluator m_evaluator;
+  TranspositionTable& m_tt;
+  TimeManager& m_time_manager; // only the main worker looks at the clock
+  std::atomic<bool>& m_abort_search;
+  const std::vector<Ptr>& m_workers; // every worker including this one, the main thread reports their total nodes
+
+  Move m_best_move;
+  Move m_best_move_this_iteration;
+  int m_best_score_this_iteration;
+  int m_best_score;
+  int m_completed_depth;
+
+  std::atomic<uint64_t> m_nodes; // only written by this worker, atomic so the main thread can sum them while searching
+  uint64_t m_next_time_check;
+  int m_seldepth; // deepest ply reached this iteration, quiescence included
 
+  /*
+    Triangular PV table, m_pv[ply] holds the best line found from ply onwards, from m_pv[ply][ply]
+    to m_pv[ply][m_pv_length[ply] - 1]. A new best move at ply copies the line of the ply below it.
+  */
+  Move m_pv[constants::MAX_PLY][constants::MAX_PLY];
+  int m_pv_length[constants::MAX_PLY];
+  std::vector<Move> m_root_pv; // line of the last root search that found one, kept across fail lows
+
+  /// @brief single writer increment, a plain add instead of a locked one
+  inline void count_node() { m_nodes.store(m_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+  /// @brief makes move followed by the line below it the best line at ply
+  void update_pv(int ply_from_root, Move move);
+
+  void check_time();
+
+  /**
+   * @brief Prints a uci info line for a finished root search, main thread only
+   * @param[in] depth depth of the iteration
+   * @param[in] score score the root search returned
+   * @param[in] alpha, beta aspiration window it was searched with, a score outside it is reported as a bound
+  */
+  void report_iteration(int depth, int score, int64_t alpha, int64_t beta) const;
+  int qsearch(int ply_from_root, int alpha, int beta);
+  int search(int ply_from_root, int depth, int alpha, int beta, bool is_pv = false, bool can_null = false);
+};
+
+/**
+ * @brief Owns the search threads. A single persistent thread waits on a condition variable for
+ * start_search, runs the search and prints bestmove itself, so the caller (the uci loop) never blocks.
+ */
 /// TODO: construct the transposition table inside of here
 class Searcher
 {
@@ -31,33 +121,102 @@ public:
   using ConstPtr = std::shared_ptr<const Searcher>;
   
   Searcher(Board::Ptr board);
+  ~Searcher();
 
-  uint64_t perft(int depth);
+  /**
+   * @brief Counts the leaf nodes depth plies below the current position and prints them per root
+   * move, followed by the total, time and nps. The root moves are shared out between threads and
+   * transposed subtrees are counted once, through a perft table.
+   * @param[in] depth number of plies to count
+   * @param[in] threads number of threads to count with
+   * @return total number of leaf nodes
+  */
+  uint64_t perft(int depth, size_t threads = 1);
   uint64_t num_nodes_bulk(int depth);
   uint64_t num_nodes(int depth);
-  void find_best_move(); // searches forever 
-  void ponder();
-  void stop();
-  void find_best_move_timed(int time); // searches for time milliseconds
+  void find_best_move(const TimeManager::Limits& limits = {}); // blocking search on the calling thread
+
+  /**
+   * @brief Hands the current position to the search thread and returns immediately. The search
+   * thread prints bestmove when it is done.
+   * @param[in] limits when to stop, searches until stopped by default
+  */
+  void start_search(const TimeManager::Limits& limits = {});
+  void stop(); // asks the running search to stop, doesn't wait for it
+  void wait(); // blocks until the search thread is idle
+  void halt(); // stops any running search and waits for it, for anything that needs the board or tables to hold still
   Move get_best_move();
   void abort_search();
 
+  /**
+   * @brief Sets the number of threads used by the search (1 main thread + helpers)
+   * @param[in] threads total number of search threads
+  */
+  void set_threads(size_t threads);
+  size_t get_threads() const;
+
+  /// @brief clears the transposition table and every thread's eval cache and pawn table
+  void clear_tt();
+  uint64_t get_nodes() const;
+
+  /**
+   * @brief Reallocates the shared transposition table, only between searches
+   * @param[in] megabytes new size, rounded down to a power of two
+  */
+  void set_hash_size(size_t megabytes);
+
+  /**
+   * @brief Saves the transposition table to disk or loads a saved one, see TranspositionTable::save
+   * @param[in] path file to write or read
+   * @return true on success
+  */
+  bool save_tt(const std::string& path);
+  bool load_tt(const std::string& path);
+
+  /**
+   * @brief Reallocates the eval cache and pawn table of every search thread
+   * @param[in] eval_cache_mb eval cache size per thread in megabytes
+   * @param[in] pawn_hash_mb pawn table size per thread in megabytes
+  */
+  void set_eval_table_sizes(size_t eval_cache_mb, size_t pawn_hash_mb);
+  inline size_t get_eval_cache_mb() const { return m_eval_cache_mb; }
+  inline size_t get_pawn_hash_mb() const { return m_pawn_hash_mb; }
+
+  /// @brief sizes of the hash tables and the kind of pages backing each of them, for an info string
+  std::string get_memory_info() const;
+
+  /**
+   * @brief Swaps the opening book, .bin files are read as Polyglot books
+   * @param[in] path book to use
+   * @return true if the book was opened
+  */
+  bool set_book(const std::string& path);
+  void set_book_best_move(bool best_move_only);
+
 private:
   Board::Ptr m_board;
   MoveGenerator m_move_gen;
   OpeningBook m_opening_book;
-  Evaluator m_evaluator;
   TranspositionTable m_tt;
+  size_t m_eval_cache_mb; // per thread sizes, new threads get these too
+  size_t m_pawn_hash_mb;
+  TimeManager m_time_manager;
+
+  std::vector<SearchWorker::Ptr> m_workers; // m_workers[0] is the main thread
 
   std::thread m_search_thread;
+  std::mutex m_mutex; // guards everything below that the search thread waits on
+  std::condition_variable m_search_cv;
+  int m_max_depth;
+  bool m_searching;
+  bool m_quit;
 
   Move m_best_move;
-  Move m_best_move_this_iteration;
-  int m_best_score_this_iteration;
   int m_best_score;
 
-  bool m_abort_search;
+  std::atomic<bool> m_abort_search;
 
-  int qsearch(int alpha, int beta);
-  int search(int ply_from_room, int depth, int alpha, int beta, bool is_pv = false, bool can_null = false);
-};
\ No newline at end of file
+  void prepare_search();
+  void run_search(int max_depth);
+  void search_thread_loop();
+};
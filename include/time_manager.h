@@ -0,0 +1,68 @@
+/**
+ * @file time_manager.h
+ * @author Jason Stentz (jstentz@andrew.cmu.edu)
+ * @brief Decides how long a search is allowed to think
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+/**
+ * @brief Turns the clock information from the go command into two limits. The soft limit is
+ * checked between iterations: once it has passed (or the next iteration clearly can't finish
+ * in time) we don't start another ply. The hard limit is checked from inside the search and
+ * aborts it outright. An unstable best move stretches the soft limit.
+ */
+class TimeManager
+{
+public:
+  /**
+   * @brief Everything the go command can limit the search by. Times are in milliseconds,
+   * and a value of 0 means it wasn't given.
+   */
+  struct Limits
+  {
+    int time_left = 0;
+    int increment = 0;
+    int moves_to_go = 0;
+    int move_time = 0;
+    int depth = INT_MAX;
+  };
+
+  /**
+   * @brief Starts the clock and computes the limits for this search
+   * @param[in] limits limits from the go command
+  */
+  void start(const Limits& limits);
+
+  /**
+   * @brief Called by the main thread after every completed iteration
+   * @param[in] best_move_changed did this iteration pick a different move than the last one
+  */
+  void iteration_finished(bool best_move_changed);
+
+  /**
+   * @brief Checks, between iterations, if starting another ply is worth it
+   * @param[in] last_iteration_ms how long the iteration that just finished took
+  */
+  bool should_stop(int64_t last_iteration_ms) const;
+
+  bool hard_limit_reached() const;
+  int64_t elapsed() const;
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+  bool m_use_clock; // playing on a clock (wtime/btime), soft limit and instability apply
+  bool m_limited; // false for infinite and depth only searches
+  int64_t m_soft_limit;
+  int64_t m_hard_limit;
+  double m_best_move_changes; // decaying count of best move changes in recent iterations
+};
@@ -13,18 +13,27 @@
 
 #include "include/hashing.h"
 #include "include/move.h"
+#include "include/large_pages.h"
 
 #include <climits>
+#include <cstdint>
+#include <atomic>
 #include <unordered_set>
 #include <optional>
+#include <string>
 
-/// TODO: make this more in the c++ style (using std::allocator?)s
+/**
+ * @brief Shared transposition table. Entries are grouped into cache line sized buckets, and
+ * every entry stores its key xor'd with its data so that any number of search threads can
+ * probe and store without locks. A torn entry (key from one write, data from another) 
+ * simply fails the key check.
+ */
 class TranspositionTable
 {
 public:
-  /// TODO: make this an easier number (megabytes) and then round to a power of 2 for them 
-  TranspositionTable(size_t entries);
-  ~TranspositionTable(); // make this free the pointer to the memory
+  /// @brief sized in megabytes, rounded down to a power of two
+  TranspositionTable(size_t megabytes);
+  ~TranspositionTable();
 
   enum Flags : char
   {
@@ -33,32 +42,119 @@ public:
     BETA
   };
 
-  std::optional<int> fetch_score(uint64_t hash, int depth, int ply_searched, int alpha, int beta); // for search
+  std::optional<int> fetch_score(uint64_t hash, int depth, int ply_searched, int alpha, int beta);
+
+  /// @brief starts loading the bucket for hash into cache, without waiting for it
+  inline void prefetch(uint64_t hash) const { __builtin_prefetch(&m_table[hash & (m_buckets - 1)]); }
   Move fetch_best_move(uint64_t hash);
-  std::optional<int> fetch_score(uint64_t hash, int alpha, int beta); // for eval
 
-  void store(uint64_t hash, int depth, int ply_searched, Flags flags, int score, Move best_move); // for search
-  void store(uint64_t hash, Flags flags, int score); // for eval
-  void clear();
+  void store(uint64_t hash, int depth, int ply_searched, Flags flags, int score, Move best_move);
+
+  /**
+   * @brief Reallocates the table, throwing away everything in it. Only call this between searches.
+   * @param[in] megabytes new size, rounded down to a power of two
+  */
+  void resize(size_t megabytes);
+
+  /**
+   * @brief Zeroes the table, split between several threads so large tables clear quickly
+   * @param[in] threads number of threads to clear with
+  */
+  void clear(size_t threads = 1);
+
+  /**
+   * @brief Writes the whole table to a file, behind a header that records the zobrist seed
+   * and entry layout it was built with. Only call this between searches. The file is written next
+   * to path and renamed over it, so saving over the snapshot the table was loaded from is safe.
+   * @param[in] path file to write
+   * @return true if the file was written
+  */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Replaces the table with one saved by save. The file is mapped copy-on-write, so it is
+   * usable straight away and only the parts the search touches are read from disk. Files written
+   * with different zobrist keys or a different entry layout are refused. Only call this between searches.
+   * @param[in] path file to read
+   * @return true if the table was loaded, the old table is kept otherwise
+  */
+  bool load(const std::string& path);
+
+  inline size_t get_size_mb() const { return sizeof(Bucket) * m_buckets / (1024 * 1024); }
+  inline LargePageBuffer::Mode get_page_mode() const { return m_memory.get_mode(); }
+
+  /**
+   * @brief Starts a new search, making entries from older searches easier to replace
+  */
+  void new_search();
 
   double get_occupancy();
 
 private:
+  /**
+   * @brief A single entry. The data word is packed as follows from LSB to MSB
+   * Bits 0 - 15: best move (from, to, and move type)
+   * Bits 16 - 23: depth
+   * Bits 24 - 25: flags
+   * Bits 26 - 31: age of the search that stored it
+   * Bits 32 - 63: score
+   */
   struct Entry
   {
-    uint64_t key;
-    uint16_t depth;
-    Flags flags;
-    int score;
-    Move best_move;
+    std::atomic<uint64_t> key; // hash ^ data
+    std::atomic<uint64_t> data;
   };
 
-  Entry* m_table;
-  size_t m_entries;
+  static constexpr size_t BUCKET_SIZE = 4;
+
+  struct alignas(64) Bucket
+  {
+    Entry entries[BUCKET_SIZE];
+  };
+
+  /**
+   * @brief Start of a saved table, the buckets follow it directly. It is a cache line long
+   * so the buckets stay aligned when the file is mapped.
+   */
+  struct alignas(64) SnapshotHeader
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t zobrist_seed;
+    uint64_t zobrist_checksum; // catches a different rand() even with the same seed
+    uint32_t bucket_bytes;
+    uint32_t entries_per_bucket;
+    uint64_t buckets;
+    uint8_t age;
+  };
+  static_assert(sizeof(SnapshotHeader) == 64, "the buckets have to start on a cache line");
+
+  static constexpr char SNAPSHOT_MAGIC[8] = {'C', 'B', 'O', 'T', 'H', 'A', 'S', 'H'};
+  static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+  static constexpr uint64_t MOVE_MASK = 0xFFFF;
+  static constexpr uint64_t DEPTH_MASK = 0xFF;
+  static constexpr uint16_t DEPTH_OFFSET = 16;
+  static constexpr uint64_t FLAGS_MASK = 0x3;
+  static constexpr uint16_t FLAGS_OFFSET = 24;
+  static constexpr uint64_t AGE_MASK = 0x3F;
+  static constexpr uint16_t AGE_OFFSET = 26;
+  static constexpr uint16_t SCORE_OFFSET = 32;
+
+  static inline Move get_move(uint64_t data)    { return Move(data & MOVE_MASK); }
+  static inline int get_depth(uint64_t data)    { return (data >> DEPTH_OFFSET) & DEPTH_MASK; }
+  static inline Flags get_flags(uint64_t data)  { return static_cast<Flags>((data >> FLAGS_OFFSET) & FLAGS_MASK); }
+  static inline uint8_t get_age(uint64_t data)  { return (data >> AGE_OFFSET) & AGE_MASK; }
+  static inline int get_score(uint64_t data)    { return static_cast<int32_t>(data >> SCORE_OFFSET); }
+
+  uint64_t pack(int depth, Flags flags, int score, Move best_move) const;
+  std::optional<uint64_t> probe(uint64_t hash) const;
 
-  size_t m_filled_entries{};
-  size_t m_overwrites{};
+  Bucket* m_table;
+  LargePageBuffer m_memory; // page aligned, so the buckets line up with cache lines
+  size_t m_buckets;
+  uint8_t m_age;
 
   int correct_stored_mate_score(int score, int ply_searched);
   int correct_retrieved_mate_score(int score, int ply_searched);
-}; 
\ No newline at end of file
+}; 
@@ -87,6 +87,8 @@ private:
 
   void handle_uci();
   void handle_is_ready();
+  void handle_set_option(std::vector<std::string>& parsed_cmd);
+  void apply_option(const std::string& name, const std::string& value); // throws if a numeric value doesn't parse
   void handle_new_game();
   void handle_position(std::vector<std::string>& parsed_cmd, std::string& cmd);
   void handle_go(std::vector<std::string>& parsed_cmd, std::string& cmd);
@@ -97,6 +99,10 @@ private:
   /* My own commands */
   void handle_verify(std::vector<std::string>& parsed_cmd); /* takes in a depth param */
   void handle_show();
+  void handle_bench(std::vector<std::string>& parsed_cmd); /* takes in a depth and max threads param */
+  void handle_compile_book(std::vector<std::string>& parsed_cmd); /* takes in the text dump and output paths */
+  void handle_save_hash(std::vector<std::string>& parsed_cmd); /* takes in the output path */
+  void handle_load_hash(std::vector<std::string>& parsed_cmd); /* takes in the path of a saved table */
 
 
   /* GUI -> ENGINE COMMANDS */
@@ -108,17 +114,31 @@ private:
   inline static const std::string QUIT = "quit";
   inline static const std::string GO = "go";
   inline static const std::string PERFT = "perft";
+  inline static const std::string PERFT_THREADS = "threads";
   inline static const std::string STOP = "stop";
   inline static const std::string MOVETIME = "movetime";
   inline static const std::string PONDER = "ponder";
   inline static const std::string WTIME = "wtime";
   inline static const std::string BTIME = "btime";
+  inline static const std::string WINC = "winc";
+  inline static const std::string BINC = "binc";
+  inline static const std::string MOVESTOGO = "movestogo";
+  inline static const std::string DEPTH = "depth";
+  inline static const std::string INFINITE = "infinite";
+  inline static const std::string NAME = "name";
+  inline static const std::string VALUE = "value";
 
   /* ENGINE -> GUI COMMANDS */
   inline static const std::string UCIOK = "uciok\n";
   inline static const std::string READYOK = "readyok\n";
   inline static const std::string ID_NAME = "id name cbot\n";
   inline static const std::string ID_AUTHOR = "id author Jason Stentz\n";
+  inline static const std::string OPTION_THREADS = "option name Threads type spin default 1 min 1 max 512\n";
+  inline static const std::string OPTION_HASH = "option name Hash type spin default 64 min 1 max 65536\n";
+  inline static const std::string OPTION_EVALHASH = "option name EvalHash type spin default 8 min 1 max 1024\n";
+  inline static const std::string OPTION_PAWNHASH = "option name PawnHash type spin default 1 min 1 max 256\n";
+  inline static const std::string OPTION_BOOKFILE = "option name BookFile type string default assets/opening_book.cbook\n";
+  inline static const std::string OPTION_BOOKBESTMOVE = "option name BookBestMove type check default false\n";
 
   /* other constants */
   inline static const std::string STARTPOS = "startpos";
@@ -126,4 +146,15 @@ private:
   inline static const std::string FEN = "fen"; 
   inline static const std::string VERIFY = "verify";
   inline static const std::string SHOW = "show";
+  inline static const std::string BENCH = "bench";
+  inline static const std::string COMPILEBOOK = "compilebook";
+  inline static const std::string SAVEHASH = "savehash";
+  inline static const std::string LOADHASH = "loadhash";
+  inline static const std::string HASH_FILE = "assets/hash.tt";
+  inline static const std::string THREADS = "Threads";
+  inline static const std::string HASH = "Hash";
+  inline static const std::string EVALHASH = "EvalHash";
+  inline static const std::string PAWNHASH = "PawnHash";
+  inline static const std::string BOOKFILE = "BookFile";
+  inline static const std::string BOOKBESTMOVE = "BookBestMove";
 };
@@ -22,42 +22,6 @@ LookUpTable::LookUpTable()
     file = file << 1;
   }
 
-  /* creating diagonal masks */
-  /* a diagonal is identified by file - rank if file >= rank else 15 - (rank - file) */
-  mask_diagonal[0] = 0x8040201008040201;
-  mask_diagonal[1] = 0x0080402010080402;
-  mask_diagonal[2] = 0x0000804020100804;
-  mask_diagonal[3] = 0x0000008040201008;
-  mask_diagonal[4] = 0x0000000080402010;
-  mask_diagonal[5] = 0x0000000000804020;
-  mask_diagonal[6] = 0x0000000000008040;
-  mask_diagonal[7] = 0x0000000000000080;
-  mask_diagonal[8] = 0x0100000000000000;
-  mask_diagonal[9] = 0x0201000000000000;
-  mask_diagonal[10] = 0x0402010000000000;
-  mask_diagonal[11] = 0x0804020100000000;
-  mask_diagonal[12] = 0x1008040201000000;
-  mask_diagonal[13] = 0x2010080402010000;
-  mask_diagonal[14] = 0x4020100804020100;
-
-  /* creating antidiagonal masks */
-  /* an antidiagonal is identified by (7 - file) - rank if file >= rank else rank - (7 - file) + 1*/
-  mask_antidiagonal[0] = 0x0102040810204080;
-  mask_antidiagonal[1] = 0x0001020408102040;
-  mask_antidiagonal[2] = 0x0000010204081020;
-  mask_antidiagonal[3] = 0x0000000102040810; 
-  mask_antidiagonal[4] = 0x0000000001020408;
-  mask_antidiagonal[5] = 0x0000000000010204;
-  mask_antidiagonal[6] = 0x0000000000000102;
-  mask_antidiagonal[7] = 0x0000000000000001;
-  mask_antidiagonal[8] = 0x8000000000000000;
-  mask_antidiagonal[9] = 0x4080000000000000;
-  mask_antidiagonal[10] = 0x2040800000000000;
-  mask_antidiagonal[11] = 0x1020408000000000;
-  mask_antidiagonal[12] = 0x0810204080000000;
-  mask_antidiagonal[13] = 0x0408102040800000;
-  mask_antidiagonal[14] = 0x0204081020408000;
-
   /* creating piece masks */
   bitboard piece = 0x0000000000000001;
   for(size_t i = 0; i < 64; i++) {
@@ -169,82 +133,140 @@ LookUpTable::LookUpTable()
     black_pawn_pushes[sq] = spot_2;
   }
 
-  /* creating rank_attacks LUT */  
-  size_t LSB_to_first_1;
-  size_t LSB_to_second_1;
-  bitboard mask_1 = 0x1;
-  bitboard rank_attack_mask = 0xFF; // shift this at end to get attacks
-  for(size_t sq = 0; sq < 64; sq++) {
-    size_t file = utils::file(sq); // will have to multiply later to shift the bitboard into the right spot
-    for(size_t pattern = 0; pattern < 256; pattern++) {
-      LSB_to_first_1 = 0;
-      LSB_to_second_1 = 7;
-      for(size_t i = 0; i < file; i++) {
-        if((pattern >> i) & mask_1 == 1) {
-          LSB_to_first_1 = i;
-        }
-      }
-      for(size_t i = file + 1; i < 8; i++) {
-        if((pattern >> i) & mask_1 == 1) {
-          LSB_to_second_1 = i;
-          break;
-        }
-      }
-      bitboard unplaced_mask = rank_attack_mask >> (7 - (LSB_to_second_1 - LSB_to_first_1));
-      rank_attacks[sq][pattern] = (unplaced_mask << (sq - (file - LSB_to_first_1))) 
-                        & ~pieces[sq]; // removes piece square
-    }
-  }
+  /* rook and bishop attacks are shared between every lut */
+  static bool sliders_initialized = (init_slider_attacks(), true);
+  (void) sliders_initialized;
+}
 
-  /* creating file_attacks LUT */
-  for(size_t i = 0; i < 8; i++) {
-    for(size_t j = 0; j < 8; j++){
-      for(size_t pattern = 0; pattern < 256; pattern++) {
-        file_attacks[i*8 + j][pattern] = rotate_90_clockwise(rank_attacks[j*8 + (7-i)][pattern]);
+void LookUpTable::init_slider_attacks()
+{
+  const int rook_directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  const int bishop_directions[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+  init_magics(rook_magics, rook_table, rook_directions);
+  init_magics(bishop_magics, bishop_table, bishop_directions);
+  init_lines();
+}
+
+void LookUpTable::init_lines()
+{
+  for (int a = 0; a < 64; a++)
+  {
+    for (int b = 0; b < 64; b++)
+    {
+      between_table[a][b] = 0;
+      line_table[a][b] = 0;
+      if (a == b) continue;
+
+      /* the slider attacks on an empty board already know which squares line up */
+      bitboard a_bit = BIT_FROM_SQ(a);
+      bitboard b_bit = BIT_FROM_SQ(b);
+      if (get_rook_attacks(a, 0) & b_bit)
+      {
+        line_table[a][b] = (get_rook_attacks(a, 0) & get_rook_attacks(b, 0)) | a_bit | b_bit;
+        between_table[a][b] = get_rook_attacks(a, b_bit) & get_rook_attacks(b, a_bit);
+      }
+      else if (get_bishop_attacks(a, 0) & b_bit)
+      {
+        line_table[a][b] = (get_bishop_attacks(a, 0) & get_bishop_attacks(b, 0)) | a_bit | b_bit;
+        between_table[a][b] = get_bishop_attacks(a, b_bit) & get_bishop_attacks(b, a_bit);
       }
     }
-    
   }
+}
 
-  /* creating diagonal_attacks LUT */
-  size_t rotated_rank;
-  size_t rotated_sq;
-  size_t diag;
-  for(size_t i = 0; i < 8; i++) {
-    for(size_t j = 0; j < 8; j++){
-      if(i >= j) rotated_rank = i - j;
-      else       rotated_rank = 8 - (j - i);
-      rotated_sq = rotated_rank * 8 + j;
-      if(j >= i) diag = j - i;
-      else       diag = 15 - (i - j);
-      size_t sq = i * 8 + j;
-      for(size_t pattern = 0; pattern < 256; pattern++) {
-        /* still need to mask the correct diagonal */
-        diagonal_attacks[sq][pattern] = 
-          undo_pseudo_rotate_45_clockwise(rank_attacks[rotated_sq][pattern])
-          & mask_diagonal[diag] & ~pieces[sq]; // removes piece square
-      }
+/**
+ * @brief Walks the rays from a square in the given (rank, file) directions until 
+ * they hit a blocker or the edge of the board. Only used to fill the magic tables.
+ */
+static bitboard sliding_attacks(int sq, bitboard blockers, const int directions[4][2])
+{
+  bitboard attacks = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    int rank = utils::rank(sq) + directions[i][0];
+    int file = utils::file(sq) + directions[i][1];
+    while (rank >= 0 && rank < 8 && file >= 0 && file < 8)
+    {
+      bitboard bit = BIT_FROM_SQ(rank * 8 + file);
+      attacks |= bit;
+      if (bit & blockers) break;
+      rank += directions[i][0];
+      file += directions[i][1];
     }
-    
   }
+  return attacks;
+}
 
-  /* creating antidiagonal_attacks LUT */
-  for(size_t i = 0; i < 8; i++) {
-    for(size_t j = 0; j < 8; j++){
-      if(j > (7 - i)) diag = 15 - (j - (7 - i));
-      else             diag = (7 - i) - j;
-      if(diag == 0)     rotated_rank = 0;
-      else if(diag <= 7) rotated_rank = 8 - diag;
-      else              rotated_rank = 8 - (diag - 7);
-      rotated_sq = rotated_rank * 8 + j;
-      size_t sq = i * 8 + j;
-      for(size_t pattern = 0; pattern < 256; pattern++) {
-        /* still need to mask the correct diagonal */
-        antidiagonal_attacks[sq][pattern] = 
-          undo_pseudo_rotate_45_anticlockwise(rank_attacks[rotated_sq][pattern])
-          & mask_antidiagonal[diag] & ~pieces[sq]; // removes piece square
+void LookUpTable::init_magics(Magic magics[64], bitboard table[], const int directions[4][2])
+{
+  bitboard occupancies[4096];
+  bitboard reference[4096];
+  int epoch[4096] = {};
+  int attempt = 0;
+
+  /* fixed per rank seeds that are known to find every magic quickly (xorshift64*) */
+  const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+  uint64_t seed;
+  auto rand64 = [&seed]() {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 2685821657736338717ULL;
+  };
+
+  bitboard* attacks = table;
+  for (int sq = 0; sq < 64; sq++)
+  {
+    /* the edges never block anything further, unless the slider is on that edge */
+    bitboard edges = ((0x00000000000000FFULL | 0xFF00000000000000ULL) & ~(0x00000000000000FFULL << (8 * utils::rank(sq)))) |
+                     ((0x0101010101010101ULL | 0x8080808080808080ULL) & ~(0x0101010101010101ULL << utils::file(sq)));
+
+    Magic& m = magics[sq];
+    m.mask = sliding_attacks(sq, 0, directions) & ~edges;
+    m.shift = 64 - pop_count(m.mask);
+    m.attacks = attacks;
+
+    /* enumerate every subset of the mask (carry-rippler) with its attack set */
+    int size = 0;
+    bitboard blockers = 0;
+    do 
+    {
+      occupancies[size] = blockers;
+      reference[size] = sliding_attacks(sq, blockers, directions);
+#if defined(USE_PEXT)
+      m.attacks[_pext_u64(blockers, m.mask)] = reference[size];
+#endif
+      size++;
+      blockers = (blockers - m.mask) & m.mask;
+    } while (blockers);
+    attacks += size;
+
+#if !defined(USE_PEXT)
+    /* search for a magic that maps every subset without destructive collisions */
+    seed = seeds[utils::rank(sq)];
+    for (int i = 0; i < size; )
+    {
+      do
+      {
+        m.magic = rand64() & rand64() & rand64(); // sparse numbers make better magics
+      } while (pop_count((m.magic * m.mask) >> 56) < 6);
+
+      attempt++;
+      for (i = 0; i < size; i++)
+      {
+        unsigned int index = m.index(occupancies[i]);
+        if (epoch[index] < attempt)
+        {
+          epoch[index] = attempt;
+          m.attacks[index] = reference[i];
+        }
+        else if (m.attacks[index] != reference[i])
+        {
+          break;
+        }
       }
     }
+#endif
   }
 }
 
@@ -267,53 +289,6 @@ bitboard LookUpTable::get_pawn_attacks(int sq, bool white_side) const
   return black_pawn_attacks[sq];
 }
 
-bitboard LookUpTable::get_rook_attacks(int rook_sq, bitboard blockers) const
-{
-  // depends on the placement of blockers on the board
-  // could leave out the white king when calculating blacks attack maps
-  size_t rook_rank = utils::rank(rook_sq);
-  size_t rook_file = utils::file(rook_sq);
-  bitboard rank_pattern = (blockers & mask_rank[rook_rank]) >> (rook_rank * 8);
-  bitboard file_pattern = rotate_90_anticlockwise(blockers & mask_file[rook_file]) >> (rook_file * 8);
-  return rank_attacks[rook_sq][rank_pattern] |
-       file_attacks[rook_sq][file_pattern];
-}
-
-bitboard LookUpTable::get_bishop_attacks(int bishop_sq, bitboard blockers) const
-{
-  // depends on the placement of blockers on the board
-  // could leave out the white king when calculating blacks attack maps
-  // this code is literal dog shit please clean it up later jason...
-  size_t bishop_rank = utils::rank(bishop_sq);
-  size_t bishop_file = utils::file(bishop_sq);
-  size_t bishop_diag;
-  if(bishop_file >= bishop_rank) bishop_diag = bishop_file - bishop_rank;
-  else                           bishop_diag = 15 - (bishop_rank - bishop_file);
-  // do same for antidiag
-  size_t bishop_antidiag;
-  if(bishop_file > (7 - bishop_rank)) bishop_antidiag = 15 - (bishop_file - (7 - bishop_rank));
-  else                                bishop_antidiag = (7 - bishop_rank) - bishop_file;
-
-  size_t rotated_rank;
-  if(bishop_diag == 0) rotated_rank = 0;
-  else if (bishop_diag < 8) rotated_rank = 8 - bishop_diag;
-  else rotated_rank = 8 - (bishop_diag - 7);
-  bitboard diag_pattern = pseudo_rotate_45_clockwise(blockers & mask_diagonal[bishop_diag]) >> (8 * rotated_rank);
-  size_t antirotated_rank;
-  if(bishop_antidiag == 0)      antirotated_rank = 0;
-  else if(bishop_antidiag < 8)  antirotated_rank = 8 - bishop_antidiag;
-  else                          antirotated_rank = 8 - (bishop_antidiag - 7);
-  bitboard antidiag_pattern = pseudo_rotate_45_anticlockwise(blockers & mask_antidiagonal[bishop_antidiag]) >> (8 * antirotated_rank);
-  return diagonal_attacks[bishop_sq][diag_pattern] |
-         antidiagonal_attacks[bishop_sq][antidiag_pattern];
-}
-
-bitboard LookUpTable::get_queen_attacks(int queen_sq, bitboard blockers) const 
-{
-  return get_bishop_attacks(queen_sq, blockers) |
-         get_rook_attacks(queen_sq, blockers);
-}
-
 bitboard LookUpTable::get_ray_from_bishop_to_king(int bishop_sq, int king_sq) const
 {
   bitboard board = pieces[bishop_sq] | pieces[king_sq];
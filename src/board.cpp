@@ -10,6 +10,8 @@
 #include "include/evaluation.h"
 #include "include/hashing.h"
 #include "include/tt.h"
+#include "include/eval_cache.h"
+#include "include/pawns.h"
 #include "include/utils.h"
 
 ///////////////////////////////////////////////// BOARD CREATION /////////////////////////////////////////////////
@@ -82,7 +84,6 @@ void Board::reset(std::string fen)
     if(PIECE(pc) != KING && PIECE(pc) != EMPTY) 
     {
       m_material_score += constants::piece_values[utils::index_from_pc(pc)];
-      m_positional_score += constants::piece_scores[utils::index_from_pc(pc)][pc_loc];
       m_total_material += abs(constants::piece_values[utils::index_from_pc(pc)]);
     }
     col++;
@@ -127,6 +128,7 @@ void Board::reset(std::string fen)
                                 Move::NO_MOVE};
   m_irr_state_history.clear();
   m_irr_state_history.push_back(start_state);
+  update_check_info(m_irr_state_history.back());
 
   m_board_hash = m_hasher.hash_board(m_white_turn, m_sq_board, white_king_side, white_queen_side, black_king_side, black_queen_side, en_passant); 
   m_piece_hash = m_hasher.hash_pieces(m_sq_board); 
@@ -163,9 +165,11 @@ void Board::clear()
   m_board_hash = 0;
   m_piece_hash = 0;
   m_pawn_hash = 0;
+  m_polyglot_piece_hash = 0;
 
   m_material_score = 0;
-  m_positional_score = 0;
+  m_psq_score = 0;
+  m_phase = 0;
   m_total_material = 0;
 
   for (size_t i = 0; i < constants::NUM_PIECE_TYPES - 2; i++) // don't include kings here
@@ -207,9 +211,6 @@ void Board::make_move(Move move)
    */
   piece moving_piece = m_sq_board[from];
   remove_piece(moving_piece, from);
-
-  if(PIECE(moving_piece) != KING) // king done seperately during eval for endgame
-    m_positional_score -= constants::piece_scores[utils::index_from_pc(moving_piece)][from];
   
   /* XOR out the piece from hash value */
   uint64_t from_zobrist = m_hasher.get_hash_val(moving_piece, from);
@@ -282,8 +283,6 @@ void Board::make_move(Move move)
         board_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::F1); // place white rook on F1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::H1); // remove white rook from H1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::F1); // place white rook on F1
-        m_positional_score -= constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::H1];
-        m_positional_score += constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::F1];
       }
       else { // black king side
         remove_piece(BLACK | ROOK, constants::H8);
@@ -292,8 +291,6 @@ void Board::make_move(Move move)
         board_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::F8); // place black rook on F8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::H8); // remove black rook from H8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::F8); // place black rook on F8
-        m_positional_score -= constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::H8];
-        m_positional_score += constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::F8];
       }
       break;
     case Move::QUEEN_SIDE_CASTLE:
@@ -307,8 +304,6 @@ void Board::make_move(Move move)
         board_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::D1); // place white rook on D1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::A1); // remove white rook from A1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::D1); // place white rook on D1
-        m_positional_score -= constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::A1];
-        m_positional_score += constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::D1];
       }
       else { // black queen side
         remove_piece(BLACK | ROOK, constants::A8);
@@ -317,8 +312,6 @@ void Board::make_move(Move move)
         board_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::D8); // place black rook on D8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::A8); // remove black rook from A8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::D8); // place black rook on D8
-        m_positional_score -= constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::A8];
-        m_positional_score += constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::D8];
       }
       break;
     case Move::NORMAL_CAPTURE:
@@ -444,15 +437,17 @@ void Board::make_move(Move move)
   if(curr_en_passant_sq != constants::NONE)
     board_hash ^= m_hasher.get_en_passant_hash(curr_en_passant_sq); // place the current en passant file in hash value
 
+  /* reverse the black_to_move hash */
+  board_hash ^= m_hasher.get_black_to_move_hash();
+
+  /* the keys are final now, start pulling in the table entries while we do the rest of the bookkeeping */
+  prefetch(board_hash, pawn_hash);
+
   /* add the last captured piece to the state */
   state.set_last_capture(captured_piece);
 
   /* update evaluation items */
   if(captured_piece != EMPTY){
-    if(type == Move::EN_PASSANT_CAPTURE)
-      m_positional_score -= constants::piece_scores[utils::index_from_pc(captured_piece)][opponent_pawn_sq];
-    else
-      m_positional_score -= constants::piece_scores[utils::index_from_pc(captured_piece)][to];
     m_material_score -= constants::piece_values[utils::index_from_pc(captured_piece)];
     m_piece_counts[utils::index_from_pc(captured_piece)]--;
     m_total_material -= abs(constants::piece_values[utils::index_from_pc(captured_piece)]);
@@ -470,24 +465,19 @@ void Board::make_move(Move move)
       m_total_material -= abs(constants::piece_values[constants::BLACK_PAWNS_INDEX]);
     }
     m_material_score += constants::piece_values[utils::index_from_pc(promo_piece)];
-    m_positional_score += constants::piece_scores[utils::index_from_pc(promo_piece)][to];
     m_piece_counts[utils::index_from_pc(promo_piece)]++;
     m_total_material += abs(constants::piece_values[utils::index_from_pc(promo_piece)]);
   }
-  else if(PIECE(moving_piece) != KING) {
-    m_positional_score += constants::piece_scores[utils::index_from_pc(moving_piece)][to];
-  }
 
   /* if we make an irreversible move, remember it! */
   if(move.is_capture() || move.is_promo() || PIECE(moving_piece) == PAWN)
     state.set_irr_ply(m_ply);
   
   m_white_turn = !m_white_turn;
-  /* reverse the black_to_move hash */
-  board_hash ^= m_hasher.get_black_to_move_hash();
 
   update_redundant_boards();
   state.set_last_move(move);
+  update_check_info(state);
   m_board_hash = board_hash;
   m_piece_hash = piece_hash;
   m_pawn_hash = pawn_hash;
@@ -568,8 +558,6 @@ void Board::unmake_move(Move move) {
         board_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::H1); // place white rook on H1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::F1); // remove white rook from F1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::H1); // place white rook on H1
-        m_positional_score -= constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::F1];
-        m_positional_score += constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::H1];
       }
       else { // black king side
         remove_piece(BLACK | ROOK, constants::F8);
@@ -578,8 +566,6 @@ void Board::unmake_move(Move move) {
         board_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::H8); // place black rook on H8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::F8); // remove black rook from F8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::H8); // place black rook on H8
-        m_positional_score -= constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::F8];
-        m_positional_score += constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::H8];
       }
       break;
     case Move::QUEEN_SIDE_CASTLE:
@@ -599,8 +585,6 @@ void Board::unmake_move(Move move) {
         board_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::A1); // place white rook on A1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::D1); // remove white rook from D1
         piece_hash ^= m_hasher.get_hash_val(WHITE | ROOK, constants::A1); // place white rook on A1
-        m_positional_score -= constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::D1];
-        m_positional_score += constants::piece_scores[constants::WHITE_ROOKS_INDEX][constants::A1];
       }
       else { // black queen side
         remove_piece(BLACK | ROOK, constants::D8);
@@ -609,8 +593,6 @@ void Board::unmake_move(Move move) {
         board_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::A8); // place black rook on A8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::D8); // remove black rook from D8
         piece_hash ^= m_hasher.get_hash_val(BLACK | ROOK, constants::A8); // place black rook on A8
-        m_positional_score -= constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::D8];
-        m_positional_score += constants::piece_scores[constants::BLACK_ROOKS_INDEX][constants::A8];
       }
       break;
     case Move::NORMAL_CAPTURE:
@@ -808,10 +790,6 @@ void Board::unmake_move(Move move) {
 
   /* update evaluation items */
   if(captured_piece != EMPTY){
-    if(type == Move::EN_PASSANT_CAPTURE)
-      m_positional_score += constants::piece_scores[utils::index_from_pc(captured_piece)][opponent_pawn_sq];
-    else
-      m_positional_score += constants::piece_scores[utils::index_from_pc(captured_piece)][to];
     m_material_score += constants::piece_values[utils::index_from_pc(captured_piece)];
     m_piece_counts[utils::index_from_pc(captured_piece)]++;
     m_total_material += abs(constants::piece_values[utils::index_from_pc(captured_piece)]);
@@ -821,24 +799,17 @@ void Board::unmake_move(Move move) {
     if(COLOR(promo_piece) == WHITE) {
       m_material_score += constants::piece_values[constants::WHITE_PAWNS_INDEX];
       m_piece_counts[constants::WHITE_PAWNS_INDEX]++;
-      m_positional_score += constants::piece_scores[constants::WHITE_PAWNS_INDEX][from];
       m_total_material += abs(constants::piece_values[constants::WHITE_PAWNS_INDEX]);
     }
     else {
       m_material_score += constants::piece_values[constants::BLACK_PAWNS_INDEX];
       m_piece_counts[constants::BLACK_PAWNS_INDEX]++;
-      m_positional_score += constants::piece_scores[constants::BLACK_PAWNS_INDEX][from];
       m_total_material += abs(constants::piece_values[constants::BLACK_PAWNS_INDEX]);
     }
     m_material_score -= constants::piece_values[utils::index_from_pc(promo_piece)];
-    m_positional_score -= constants::piece_scores[utils::index_from_pc(promo_piece)][to];
     m_piece_counts[utils::index_from_pc(promo_piece)]--;
     m_total_material -= abs(constants::piece_values[utils::index_from_pc(promo_piece)]);
   }
-  else if(PIECE(moving_piece) != KING) {
-    m_positional_score -= constants::piece_scores[utils::index_from_pc(moving_piece)][to];
-    m_positional_score += constants::piece_scores[utils::index_from_pc(moving_piece)][from];
-  }
 
   m_white_turn = !m_white_turn;
   m_board_hash = board_hash;
@@ -857,6 +828,8 @@ void Board::make_nullmove() {
   state.set_last_move(Move::NO_MOVE);
   m_white_turn = !m_white_turn;
   m_board_hash ^= m_hasher.get_black_to_move_hash();
+  prefetch(m_board_hash, m_pawn_hash);
+  update_check_info(state); // never in check here, but the other king has other blockers
   m_irr_state_history.push_back(state);
 }
 
@@ -870,6 +843,82 @@ void Board::unmake_nullmove() {
   m_board_hash ^= m_hasher.get_black_to_move_hash();
 }
 
+void Board::update_check_info(IrreversibleState& state) const
+{
+  int king_sq = m_white_turn ? m_white_king_loc : m_black_king_loc;
+  if (king_sq == constants::NONE)
+  {
+    state.set_check_info(0, 0); // only happens with a broken fen
+    return;
+  }
+  piece them = m_white_turn ? BLACK : WHITE;
+  bitboard diagonal_sliders = get_piece_bitboard(them | BISHOP) | get_piece_bitboard(them | QUEEN);
+  bitboard cardinal_sliders = get_piece_bitboard(them | ROOK) | get_piece_bitboard(them | QUEEN);
+
+  bitboard checkers = (m_lut.get_pawn_attacks(king_sq, m_white_turn) & get_piece_bitboard(them | PAWN)) |
+                      (m_lut.get_knight_attacks(king_sq) & get_piece_bitboard(them | KNIGHT));
+
+  /* a slider lined up with the king either checks it, is held back by exactly one piece, or doesn't matter */
+  bitboard snipers = (LookUpTable::get_rook_attacks(king_sq, 0) & cardinal_sliders) | 
+                     (LookUpTable::get_bishop_attacks(king_sq, 0) & diagonal_sliders);
+  bitboard blockers = 0;
+  while (snipers)
+  {
+    int sq = first_set_bit(snipers);
+    bitboard between = LookUpTable::get_between(king_sq, sq) & m_all_pieces;
+    if (!between)
+    {
+      checkers |= BIT_FROM_SQ(sq);
+    }
+    else if (!rem_first_bit(between))
+    {
+      blockers |= between;
+    }
+    REMOVE_FIRST(snipers);
+  }
+  state.set_check_info(checkers, blockers);
+}
+
+void Board::set_prefetch_tables(const TranspositionTable* tt, const EvalCache* eval_cache, const PawnTable* pawn_table)
+{
+  m_prefetch_tt = tt;
+  m_prefetch_eval_cache = eval_cache;
+  m_prefetch_pawn_table = pawn_table;
+}
+
+void Board::prefetch(uint64_t board_hash, uint64_t pawn_hash) const
+{
+  if (m_prefetch_tt)         m_prefetch_tt->prefetch(board_hash);
+  if (m_prefetch_eval_cache) m_prefetch_eval_cache->prefetch(board_hash);
+  if (m_prefetch_pawn_table) m_prefetch_pawn_table->prefetch(pawn_hash);
+}
+
+uint64_t Board::get_polyglot_key() const
+{
+  uint64_t key = m_polyglot_piece_hash;
+  if (can_white_king_side_castle())  key ^= PolyglotHasher::get_castle_key(0);
+  if (can_white_queen_side_castle()) key ^= PolyglotHasher::get_castle_key(1);
+  if (can_black_king_side_castle())  key ^= PolyglotHasher::get_castle_key(2);
+  if (can_black_queen_side_castle()) key ^= PolyglotHasher::get_castle_key(3);
+
+  /* polyglot only hashes the en passant file if a pawn is actually next to the pushed one */
+  int en_passant_sq = get_en_passant_sq();
+  if (en_passant_sq != constants::NONE)
+  {
+    int pushed_pawn_sq = m_white_turn ? en_passant_sq - 8 : en_passant_sq + 8;
+    piece our_pawn = m_white_turn ? (WHITE | PAWN) : (BLACK | PAWN);
+    int file = utils::file(en_passant_sq);
+    if ((file > 0 && m_sq_board[pushed_pawn_sq - 1] == our_pawn) ||
+        (file < 7 && m_sq_board[pushed_pawn_sq + 1] == our_pawn))
+    {
+      key ^= PolyglotHasher::get_en_passant_key(file);
+    }
+  }
+
+  if (m_white_turn) key ^= PolyglotHasher::get_white_to_move_key();
+  return key;
+}
+
 void Board::make_moves(std::vector<Move> moves)
 {
   for (auto move : moves)
@@ -893,6 +942,9 @@ void Board::place_piece_in_bb(piece pc, int sq)
 {
   int index = utils::index_from_pc(pc);
   m_piece_boards[index] |= (1LL << sq);
+  m_polyglot_piece_hash ^= PolyglotHasher::get_piece_key(pc, sq);
+  m_psq_score += constants::psq_scores[index][sq];
+  m_phase += constants::piece_phases[index];
 }
 
 void Board::remove_piece(piece pc, int sq)
@@ -910,6 +962,9 @@ void Board::remove_piece_from_bb(piece pc, int sq)
 {
   int index = utils::index_from_pc(pc);
   m_piece_boards[index] &= ~(1LL << sq);
+  m_polyglot_piece_hash ^= PolyglotHasher::get_piece_key(pc, sq);
+  m_psq_score -= constants::psq_scores[index][sq];
+  m_phase -= constants::piece_phases[index];
 }
 
 void Board::update_redundant_boards()
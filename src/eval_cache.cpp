@@ -0,0 +1,26 @@
+#include "include/eval_cache.h"
+
+#include <algorithm>
+
+EvalCache::EvalCache(size_t megabytes)
+{
+  resize(megabytes);
+}
+
+void EvalCache::resize(size_t megabytes)
+{
+  size_t entries = std::max<size_t>(megabytes * 1024 * 1024 / sizeof(uint64_t), 1);
+  /* power of two so the hash can be masked into an index */
+  size_t size = 1;
+  while (size * 2 <= entries)
+  {
+    size *= 2;
+  }
+  m_table = static_cast<uint64_t*>(m_memory.allocate(size * sizeof(uint64_t)));
+  m_mask = size - 1;
+}
+
+void EvalCache::clear()
+{
+  std::fill(m_table, m_table + m_mask + 1, 0);
+}
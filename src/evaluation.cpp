@@ -6,9 +6,14 @@
 #include "include/utils.h"
 
 #include <cstdlib>
+#include <algorithm>
 #include <iostream>
 
-Evaluator::Evaluator(Board::Ptr board) : m_board{board}, m_table{constants::EVAL_TT_SIZE} {}
+Evaluator::Evaluator(Board::Ptr board, size_t eval_cache_mb, size_t pawn_hash_mb) : 
+  m_board{board}, 
+  m_eval_cache{eval_cache_mb}, 
+  m_pawn_table{pawn_hash_mb} 
+{}
 
 int Evaluator::evaluate(int alpha, int beta)
 {
@@ -18,12 +23,12 @@ int Evaluator::evaluate(int alpha, int beta)
 
   int perspective = (m_board->is_white_turn()) ? 1 : -1;
 
-  /* probe the eval table */
-  // std::optional<int> table_score = m_table.fetch_score(m_board->get_piece_hash(), alpha, beta); /* use the pieces since that's all that matters for eval */
-  // if (table_score)
-  // {
-  //   return table_score.value() * perspective;
-  // }
+  /* probe the eval cache, a hit skips the mobility loops and everything else below */
+  std::optional<int> cached_eval = m_eval_cache.probe(m_board->get_hash());
+  if (cached_eval)
+  {
+    return cached_eval.value() * perspective;
+  }
 
   int eval;
   int lazy_eval;
@@ -32,26 +37,24 @@ int Evaluator::evaluate(int alpha, int beta)
 
   if (!sufficient_checkmating_material()) 
   {
-    // m_table.store(m_board->get_piece_hash(), TranspositionTable::EXACT, 0);
     return 0;
   }
 
-  float game_phase = calculate_game_phase();
+  /* 0 with every piece on the board up to 256 with only kings and pawns, extra promoted pieces don't count */
+  int game_phase = ((constants::MAX_PHASE - std::min(m_board->get_phase(), constants::MAX_PHASE)) * 256 + constants::MAX_PHASE / 2) / constants::MAX_PHASE;
 
   int white_king_loc = m_board->get_white_king_loc();
   int black_king_loc = m_board->get_black_king_loc();
 
-  int middlegame_positional = m_board->get_positional_score() + 
-                constants::piece_scores[constants::WHITE_KINGS_INDEX][white_king_loc] +
-                constants::piece_scores[constants::BLACK_KINGS_INDEX][black_king_loc];
-
-  int endgame_positional = m_board->get_positional_score() + 
-               constants::piece_scores[constants::WHITE_KINGS_INDEX + 2][white_king_loc] +
-               constants::piece_scores[constants::BLACK_KINGS_INDEX + 2][black_king_loc];
+  /* material and piece-square scores are kept up to date by the board */
+  Score psq_score = m_board->get_psq_score();
+  middlegame_eval = mg_value(psq_score);
+  endgame_eval = eg_value(psq_score);
 
-  middlegame_eval = middlegame_positional + m_board->get_material_score();
-  endgame_eval = endgame_positional + m_board->get_material_score();
 
+  Score pawn_score = evaluate_pawns();
+  middlegame_eval += mg_value(pawn_score);
+  endgame_eval += eg_value(pawn_score);
 
   /* in order to do lazy eval, we will see if this exceeds the alpha-beta bounds */
   // lazy_eval = (((middlegame_eval * (256 - game_phase)) + (endgame_eval * game_phase)) / 256);
@@ -111,14 +114,15 @@ int Evaluator::evaluate(int alpha, int beta)
   // middlegame_eval -= white_pawn_shield_penalty;
   // middlegame_eval -= black_pawn_shield_penalty;
 
-  eval = (((middlegame_eval * (256.0 - game_phase)) + (endgame_eval * game_phase)) / 256);
+  eval = ((middlegame_eval * (256 - game_phase)) + (endgame_eval * game_phase)) / 256;
 
 
   if (m_board->get_piece_count(WHITE | BISHOP) >= 2) eval += 30; /* bishop pair bonus for white */
   if (m_board->get_piece_count(BLACK | BISHOP) >= 2) eval -= 30; /* bishop pair bonus for black */
   
-  /* save the evaluation we just made */
-  // m_table.store(m_board->get_piece_hash(), TranspositionTable::EXACT, eval); /* use just the pieces again */
+  /* save the evaluation we just made, it has to fit in the 16 bits the cache keeps */
+  eval = std::clamp(eval, (int)INT16_MIN, (int)INT16_MAX);
+  m_eval_cache.store(m_board->get_hash(), eval);
   return eval * perspective;
 }
 
@@ -135,47 +139,6 @@ bool Evaluator::sufficient_checkmating_material()
   return false;
 }
 
-float Evaluator::calculate_game_phase()
-{
-  int pawn_phase = 0;
-  int knight_phase = 1;
-  int bishop_phase = 1;
-  int rook_phase = 2;
-  int queen_phase = 4;
-  float total_phase = pawn_phase * 16 + 
-            knight_phase * 4 + 
-            bishop_phase * 4 + 
-            rook_phase * 4 + 
-            queen_phase * 2;
-
-  float phase = total_phase;
-  /* count the number of each piece */
-  int wp = m_board->get_piece_count(WHITE | PAWN);
-  int wn = m_board->get_piece_count(WHITE | KNIGHT);
-  int wb = m_board->get_piece_count(WHITE | BISHOP);
-  int wr = m_board->get_piece_count(WHITE | ROOK);  
-  int wq = m_board->get_piece_count(WHITE | QUEEN);
-
-  int bp = m_board->get_piece_count(BLACK | PAWN);
-  int bn = m_board->get_piece_count(BLACK | KNIGHT);
-  int bb = m_board->get_piece_count(BLACK | BISHOP);
-  int br = m_board->get_piece_count(BLACK | ROOK);  
-  int bq = m_board->get_piece_count(BLACK | QUEEN);
-
-  phase -= wp * pawn_phase;
-  phase -= wn * knight_phase;
-  phase -= wb * bishop_phase;
-  phase -= wr * rook_phase;
-  phase -= wq * queen_phase;
-
-  phase -= bp * pawn_phase;
-  phase -= bn * knight_phase;
-  phase -= bb * bishop_phase;
-  phase -= br * rook_phase;
-  phase -= bq * queen_phase;
-  return (phase * 256 + (total_phase / 2)) / total_phase;
-}
-
 int Evaluator::mop_up_eval(bool white_winning)
 {
   int eval;
@@ -198,9 +161,13 @@ int Evaluator::mop_up_eval(bool white_winning)
   return eval * perspective;
 }
 
-int Evaluator::evaluate_pawns()
+Score Evaluator::evaluate_pawns()
 {
-  return 0; // unimplemented
+  /* the structure only changes when a pawn moves, so this is almost always a table hit */
+  PawnTable::Entry* entry = m_pawn_table.probe(*m_board);
+  return entry->score + 
+         m_pawn_table.get_king_shield(entry, *m_board, true) + 
+         m_pawn_table.get_king_shield(entry, *m_board, false);
 }
 
 int Evaluator::evaluate_knights(bitboard white_king_squares, bitboard black_king_squares)
@@ -301,5 +268,12 @@ int Evaluator::evaluate_queens(bitboard white_king_squares, bitboard black_king_
 
 void Evaluator::clear_eval_table()
 {
-  m_table.clear();
+  m_eval_cache.clear();
+  m_pawn_table.clear();
+}
+
+void Evaluator::resize_tables(size_t eval_cache_mb, size_t pawn_hash_mb)
+{
+  m_eval_cache.resize(eval_cache_mb);
+  m_pawn_table.resize(pawn_hash_mb);
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "include/large_pages.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+LargePageBuffer::~LargePageBuffer()
+{
+  release();
+}
+
+/**
+ * @brief Whether the kernel will back MADV_HUGEPAGE memory with transparent huge pages. madvise
+ * succeeds even when they are turned off, so the setting has to be read to know.
+ */
+static bool transparent_huge_pages_enabled()
+{
+  static const bool enabled = [] {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string setting;
+    std::getline(file, setting); // e.g. "always [madvise] never", the bracketed one is in use
+    return setting.find("[always]") != std::string::npos || setting.find("[madvise]") != std::string::npos;
+  }();
+  return enabled;
+}
+
+void* LargePageBuffer::allocate(size_t bytes)
+{
+  release();
+  /* a block smaller than a huge page would be rounded up to a whole one, so it only gets normal pages */
+  bool huge = bytes >= HUGE_PAGE_SIZE;
+  size_t page_size = huge ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t rounded = (bytes + page_size - 1) / page_size * page_size;
+
+#if defined(MAP_HUGETLB)
+  if (huge)
+  {
+    void* memory = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED)
+    {
+      m_memory = memory;
+      m_size = rounded;
+      m_mode = Mode::HUGETLB;
+      return m_memory;
+    }
+  }
+#endif
+
+  /* no reserved huge pages, fall back to normal pages and ask for transparent huge pages */
+  void* memory_fallback = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory_fallback == MAP_FAILED)
+  {
+    std::cerr << "Could not allocate " << bytes << " bytes" << std::endl;
+    exit(1);
+  }
+  m_memory = memory_fallback;
+  m_size = rounded;
+  m_mode = Mode::NORMAL;
+#if defined(MADV_HUGEPAGE)
+  if (huge && madvise(m_memory, m_size, MADV_HUGEPAGE) == 0 && transparent_huge_pages_enabled())
+  {
+    m_mode = Mode::TRANSPARENT;
+  }
+#endif
+  return m_memory;
+}
+
+void* LargePageBuffer::map_file(int fd, size_t bytes)
+{
+  void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (memory == MAP_FAILED)
+  {
+    return nullptr; // keep whatever we had
+  }
+  madvise(memory, bytes, MADV_RANDOM); // hash tables are probed all over, don't read ahead
+  release();
+  m_memory = memory;
+  m_size = bytes;
+  m_mode = Mode::FILE;
+  return m_memory;
+}
+
+void LargePageBuffer::release()
+{
+  if (m_memory)
+  {
+    munmap(m_memory, m_size);
+  }
+  m_memory = nullptr;
+  m_size = 0;
+  m_mode = Mode::NONE;
+}
+
+std::string LargePageBuffer::mode_name(Mode mode)
+{
+  switch (mode)
+  {
+    case Mode::HUGETLB:     return "huge pages";
+    case Mode::TRANSPARENT: return "transparent huge pages";
+    case Mode::NORMAL:      return "normal pages";
+    case Mode::FILE:        return "a file mapping";
+    default:                return "no memory";
+  }
+}
@@ -20,7 +20,7 @@ void simulate_game()
     std::cout << std::hex << board->get_hash() << std::endl;
     std::cout << board->get_piece_hash() << std::endl << std::dec;
     
-    std::vector<Move> moves;
+    MoveList moves;
     move_gen.generate_moves(moves);
 
     for (int i = 0; i < moves.size(); i++)
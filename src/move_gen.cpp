@@ -13,147 +13,368 @@
 #include <algorithm>
 #include <thread>
 
-MoveGenerator::MoveGenerator(Board::Ptr board) : m_board{board} {}
+MoveGenerator::MoveGenerator(Board::Ptr board) : 
+  m_board{board}, 
+  m_continuation_history(12 * 64) 
+{}
 
-void MoveGenerator::generate_moves(std::vector<Move> &curr_moves, bool captures_only) const
+void MoveGenerator::generate_moves(MoveList &curr_moves, GenType type) const
 {
-  bitboard check_pieces = checking_pieces();
-  bitboard capture_mask = 0xFFFFFFFFFFFFFFFF;
-  bitboard push_mask = 0xFFFFFFFFFFFFFFFF;
-  int friendly_king_loc = (m_board->is_white_turn()) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
-  CheckType check = check_type(check_pieces);
-  if (check == CheckType::DOUBLE) 
+  bitboard checkers = m_board->get_checkers();
+  /* out of check ALL never needs a check mask, in check it is exactly the evasions */
+  if (type == GenType::ALL && checkers) type = GenType::EVASIONS;
+  else if (type == GenType::EVASIONS && !checkers) type = GenType::ALL;
+
+  bool white = m_board->is_white_turn();
+  switch (type)
+  {
+    case GenType::CAPTURES:
+      white ? generate<WHITE, GenType::CAPTURES>(curr_moves, checkers) : generate<BLACK, GenType::CAPTURES>(curr_moves, checkers);
+      break;
+    case GenType::QUIETS:
+      white ? generate<WHITE, GenType::QUIETS>(curr_moves, checkers) : generate<BLACK, GenType::QUIETS>(curr_moves, checkers);
+      break;
+    case GenType::EVASIONS:
+      white ? generate<WHITE, GenType::EVASIONS>(curr_moves, checkers) : generate<BLACK, GenType::EVASIONS>(curr_moves, checkers);
+      break;
+    default:
+      white ? generate<WHITE, GenType::ALL>(curr_moves, checkers) : generate<BLACK, GenType::ALL>(curr_moves, checkers);
+      break;
+  }
+}
+
+template <piece Us, MoveGenerator::GenType Type>
+void MoveGenerator::generate(MoveList &curr_moves, bitboard checkers) const
+{
+  if (check_type(checkers) == CheckType::DOUBLE) 
   {
-    generate_king_moves(curr_moves, captures_only);
+    generate_king_moves<Us, Type>(curr_moves);
     return;
   }
-  else if (check == CheckType::SINGLE) {
-    capture_mask = check_pieces;
-    int sq = first_set_bit(check_pieces);
-    if (is_sliding_piece((*m_board)[sq])) 
+
+  bool pawn_check = false;
+  bitboard check_mask = 0xFFFFFFFFFFFFFFFF;
+  if constexpr (Type != GenType::ALL) /* ALL is only generated out of check */
+  {
+    pawn_check = (checkers & m_board->get_piece_bitboard((Us ^ 1) | PAWN)) != 0;
+    check_mask = get_check_mask(checkers);
+  }
+  bitboard pinned = m_board->get_pinned_pieces();
+
+  generate_pawn_moves<Us, Type>(curr_moves, check_mask, pawn_check, pinned);
+  generate_piece_moves<Us, KNIGHT, Type>(curr_moves, check_mask, pinned);
+  generate_piece_moves<Us, BISHOP, Type>(curr_moves, check_mask, pinned);
+  generate_piece_moves<Us, ROOK, Type>(curr_moves, check_mask, pinned);
+  generate_piece_moves<Us, QUEEN, Type>(curr_moves, check_mask, pinned);
+  generate_king_moves<Us, Type>(curr_moves);
+}
+
+bool MoveGenerator::is_legal(Move move) const
+{
+  if (move.is_no_move()) return false;
+  int from = move.from();
+  int to = move.to();
+  piece mv_piece = (*m_board)[from];
+  piece color = m_board->is_white_turn() ? WHITE : BLACK;
+  if (mv_piece == EMPTY || COLOR(mv_piece) != color) return false;
+
+  bitboard check_pieces = m_board->get_checkers();
+  bitboard to_bit = BIT_FROM_SQ(to);
+  bitboard opponent_pieces = (m_board->is_white_turn()) ? m_board->get_black_pieces() : m_board->get_white_pieces();
+  bool capture = (to_bit & opponent_pieces) != 0;
+
+  /* the king's move bitboard is already fully legal */
+  if (PIECE(mv_piece) == KING) 
+  {
+    bitboard king_targets = m_board->is_white_turn() ? generate_king_move_bitboard<WHITE, GenType::ALL>(from) 
+                                                     : generate_king_move_bitboard<BLACK, GenType::ALL>(from);
+    if (!(king_targets & to_bit)) return false;
+    if (to - from == 2) return move.type() == Move::KING_SIDE_CASTLE;
+    if (to - from == -2) return move.type() == Move::QUEEN_SIDE_CASTLE;
+    return move.type() == (capture ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE);
+  }
+  if (check_type(check_pieces) == CheckType::DOUBLE) return false;
+
+  int friendly_king_loc = (m_board->is_white_turn()) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  bitboard check_mask = get_check_mask(check_pieces);
+  bitboard pinned = m_board->get_pinned_pieces();
+  bitboard pin_mask = (BIT_FROM_SQ(from) & pinned) ? LookUpTable::get_line(friendly_king_loc, from) : 0xFFFFFFFFFFFFFFFF;
+  bitboard legal_targets;
+  bitboard own_pieces = m_board->is_white_turn() ? m_board->get_white_pieces() : m_board->get_black_pieces();
+  switch (PIECE(mv_piece)) 
+  {
+    case PAWN:
     {
-      push_mask = opponent_slider_rays_to_square(friendly_king_loc);
+      bool pawn_check = (check_pieces & (m_board->get_piece_bitboard(WHITE | PAWN) | m_board->get_piece_bitboard(BLACK | PAWN))) != 0;
+      if (pawn_check && m_board->get_en_passant_sq() != constants::NONE) 
+      {
+        check_mask |= BIT_FROM_SQ(m_board->get_en_passant_sq());
+      }
+      legal_targets = m_board->is_white_turn() ? generate_pawn_move_bitboard<WHITE, GenType::ALL>(from) 
+                                               : generate_pawn_move_bitboard<BLACK, GenType::ALL>(from);
+      break;
     }
-    else 
+    case KNIGHT:
+      if (BIT_FROM_SQ(from) & pinned) return false; // pinned knights cannot move at all
+      legal_targets = piece_attacks<KNIGHT>(from, m_board->get_all_pieces()) & ~own_pieces;
+      break;
+    case BISHOP:
+      legal_targets = piece_attacks<BISHOP>(from, m_board->get_all_pieces()) & ~own_pieces;
+      break;
+    case ROOK:
+      legal_targets = piece_attacks<ROOK>(from, m_board->get_all_pieces()) & ~own_pieces;
+      break;
+    default:
+      legal_targets = piece_attacks<QUEEN>(from, m_board->get_all_pieces()) & ~own_pieces;
+      break;
+  }
+  if (!(legal_targets & check_mask & pin_mask & to_bit)) return false;
+
+  /* the target square is reachable, now make sure the flags match what generate_moves would produce */
+  if (PIECE(mv_piece) != PAWN) 
+  {
+    return move.type() == (capture ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE);
+  }
+  int to_rank = utils::rank(to);
+  if (to_rank == constants::RANK_8 || to_rank == constants::RANK_1) 
+  {
+    return move.is_promo() && move.is_capture() == (utils::file(to) != utils::file(from));
+  }
+  if (abs(from - to) == 16) return move.type() == Move::DOUBLE_PUSH;
+  if (to == m_board->get_en_passant_sq()) return move.type() == Move::EN_PASSANT_CAPTURE;
+  return move.type() == (capture ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE);
+}
+
+/// TODO: make tt_best_move an optional with a default
+void MoveGenerator::order_moves(MoveList& moves, Move tt_best_move, std::optional<int> ply_from_root) const
+{
+  OrderingContext context = get_ordering_context(ply_from_root);
+  for (Move& mv : moves) 
+  {
+    if (!tt_best_move.is_no_move() && mv == tt_best_move) 
     {
-      push_mask = 0;
+      mv.set_score(30000); // idk try the PV node first
+      continue;
     }
+    mv.set_score(score_move(mv, context));
   }
+  moves.sort();
+}
 
-  bool pawn_check = (check_pieces & (m_board->get_piece_bitboard(WHITE | PAWN) | m_board->get_piece_bitboard(BLACK | PAWN))) != 0;
-  bitboard check_mask = push_mask | capture_mask;
-  Pin pin = get_pinned_pieces(friendly_king_loc); // maybe change this so that the board holds the pinned pieces info
-
-  generate_pawn_moves(curr_moves, check_mask, pawn_check, pin, captures_only);
-  generate_knight_moves(curr_moves, check_mask, pin, captures_only);
-  generate_bishop_moves(curr_moves, check_mask, pin, captures_only);
-  generate_rook_moves(curr_moves, check_mask, pin, captures_only);
-  generate_queen_moves(curr_moves, check_mask, pin, captures_only);
-  generate_king_moves(curr_moves, captures_only);
+void MoveGenerator::score_moves(MoveList& moves, std::optional<int> ply_from_root) const
+{
+  OrderingContext context = get_ordering_context(ply_from_root);
+  for (Move& mv : moves) 
+  {
+    mv.set_score(score_move(mv, context));
+  }
 }
 
-/// TODO: make tt_best_move an optional with a default
-void MoveGenerator::order_moves(std::vector<Move>& moves, Move tt_best_move, std::optional<int> ply_from_root) const
+MoveGenerator::OrderingContext MoveGenerator::get_ordering_context(std::optional<int> ply_from_root) const
 {
-  signed short int score;
-  piece mv_piece;
-  piece tar_piece;
-  int to;
-  int from;
-  Move mv;
-  int flags;
-  int perspective = m_board->is_white_turn() ? 1 : -1;
-  // maybe add a bonus for castling moves
-  // add recapturing the piece that was last captured as a good bonus to check first
-  // bigger bonus for the higher value piece being captured
-  // just have the board store the move that was made to get to that position
-  // still need to add the least_valued_attacker logic, not exactly sure how to implement
+  OrderingContext context{get_recapture_square(), ply_from_root, Move::NO_MOVE, {nullptr, nullptr}};
+  if (!ply_from_root.has_value())
+  {
+    return context; // captures don't use the quiet move heuristics
+  }
+
   Move last_move = m_board->get_last_move();
-  int recapture_square = -1;
-  if (!last_move.is_no_move() && last_move.is_capture()) 
+  if (!last_move.is_no_move())
   {
-    recapture_square = last_move.to();
+    context.counter_move = m_counter_moves[utils::index_from_pc((*m_board)[last_move.to()])][last_move.to()];
   }
-  for (Move& mv : moves) 
+  for (size_t plies_ago = 0; plies_ago < 2; plies_ago++)
   {
-    score = 0;
-    if (!tt_best_move.is_no_move() && mv == tt_best_move) 
+    int index = get_continuation_index(plies_ago);
+    context.continuations[plies_ago] = (index >= 0) ? &m_continuation_history[index] : nullptr;
+  }
+  return context;
+}
+
+int MoveGenerator::get_continuation_index(size_t plies_ago) const
+{
+  Move move = m_board->get_previous_move(plies_ago);
+  if (move.is_no_move())
+  {
+    return -1;
+  }
+  /* the piece that moved is still on its to square, unless the move after it captured it there */
+  piece pc = (*m_board)[move.to()];
+  bool mover_is_white = (plies_ago % 2 == 0) != m_board->is_white_turn();
+  if (pc == EMPTY || COLOR(pc) != (mover_is_white ? WHITE : BLACK))
+  {
+    return -1;
+  }
+  return utils::index_from_pc(pc) * 64 + move.to();
+}
+
+int MoveGenerator::get_history(Move move) const
+{
+  int history = m_history[m_board->is_white_turn() ? WHITE : BLACK][move.from()][move.to()];
+  int pc_index = utils::index_from_pc((*m_board)[move.from()]);
+  for (size_t plies_ago = 0; plies_ago < 2; plies_ago++)
+  {
+    int index = get_continuation_index(plies_ago);
+    if (index >= 0)
     {
-      score += 30000; // idk try the PV node first
-      mv.set_score(score);
-      continue;
+      history += m_continuation_history[index][pc_index][move.to()];
     }
-    to = mv.to();
-    from = mv.from();
-    flags = mv.type();
-    mv_piece = (*m_board)[from];
-    if (mv.is_promo()) 
+  }
+  return history;
+}
+
+void MoveGenerator::update_quiet_histories(int ply_from_root, Move best_move, const MoveList& quiets_tried, int depth)
+{
+  insert_killer(ply_from_root, best_move);
+
+  Move last_move = m_board->get_last_move();
+  if (!last_move.is_no_move())
+  {
+    m_counter_moves[utils::index_from_pc((*m_board)[last_move.to()])][last_move.to()] = best_move;
+  }
+
+  int continuation_indices[2] = {get_continuation_index(0), get_continuation_index(1)};
+  int color = m_board->is_white_turn() ? WHITE : BLACK;
+  int bonus = std::min(16 * depth * depth, constants::HISTORY_BONUS_MAX);
+
+  auto update = [&](Move move, int move_bonus) {
+    update_gravity(m_history[color][move.from()][move.to()], move_bonus);
+    int pc_index = utils::index_from_pc((*m_board)[move.from()]);
+    for (int index : continuation_indices)
     {
-      if (flags == Move::KNIGHT_PROMO || flags == Move::KNIGHT_PROMO_CAPTURE) {
-        score += constants::piece_values[constants::WHITE_KNIGHTS_INDEX]; // just use the white knights because positive value
-      }
-      else if (flags == Move::BISHOP_PROMO || flags == Move::BISHOP_PROMO_CAPTURE) {
-        score += constants::piece_values[constants::WHITE_BISHOPS_INDEX];
-      }
-      else if (flags == Move::ROOK_PROMO || flags == Move::ROOK_PROMO_CAPTURE) {
-        score += constants::piece_values[constants::WHITE_ROOKS_INDEX];
-      }
-      else {
-        score += constants::piece_values[constants::WHITE_QUEENS_INDEX];
+      if (index >= 0)
+      {
+        int entry = m_continuation_history[index][pc_index][move.to()];
+        update_gravity(entry, move_bonus);
+        m_continuation_history[index][pc_index][move.to()] = entry;
       }
     }
-    /* check recapturing moves */
-    if (to == recapture_square) 
+  };
+
+  update(best_move, bonus);
+  for (Move move : quiets_tried)
+  {
+    update(move, -bonus);
+  }
+}
+
+void MoveGenerator::age_history()
+{
+  for (auto& from_table : m_history)
+  {
+    for (auto& to_table : from_table)
     {
-      score += 5 * abs(constants::piece_values[utils::index_from_pc(mv_piece)]); // arbitrary multiplication
-    }
-    else if (mv.is_capture()) {
-      // score += see_capture(mv); /* this function isn't fast enough I need incrementally updated attack tables */
-      tar_piece = (*m_board)[to];
-      if (!is_attacked(to, m_board->get_all_pieces())) 
+      for (int& entry : to_table)
       {
-        score += 5 * abs(constants::piece_values[utils::index_from_pc(tar_piece)]);
+        entry /= 2;
       }
-      else 
+    }
+  }
+  for (PieceToHistory& table : m_continuation_history)
+  {
+    for (auto& to_table : table)
+    {
+      for (int16_t& entry : to_table)
       {
-        score += abs(constants::piece_values[utils::index_from_pc(tar_piece)]) - abs(constants::piece_values[utils::index_from_pc(mv_piece)]);    
+        entry /= 2;
       }
     }
-    /* score moves to squares attacked by pawns */
-    else if(PIECE(mv_piece) != PAWN && is_attacked_by_pawn(to)) 
-      score -= abs(constants::piece_values[utils::index_from_pc(mv_piece)]); // can play around with this
-    
-    // done for better endgame move ordering of king moves
-    if (PIECE(mv_piece) == KING && m_board->get_piece_bitboard(WHITE | QUEEN) == 0 && m_board->get_piece_bitboard(BLACK | QUEEN) == 0)
-    {
-      score += perspective * (constants::piece_scores[utils::index_from_pc(mv_piece) + 2][to] - constants::piece_scores[utils::index_from_pc(mv_piece) + 2][from]);
+  }
+}
+
+int MoveGenerator::get_recapture_square() const
+{
+  // add recapturing the piece that was last captured as a good bonus to check first
+  // just have the board store the move that was made to get to that position
+  Move last_move = m_board->get_last_move();
+  if (!last_move.is_no_move() && last_move.is_capture()) 
+  {
+    return last_move.to();
+  }
+  return -1;
+}
+
+int MoveGenerator::score_move(Move mv, const OrderingContext& context) const
+{
+  // maybe add a bonus for castling moves
+  // bigger bonus for the higher value piece being captured
+  // still need to add the least_valued_attacker logic, not exactly sure how to implement
+  signed short int score = 0;
+  int perspective = m_board->is_white_turn() ? 1 : -1;
+  int to = mv.to();
+  int from = mv.from();
+  int flags = mv.type();
+  piece mv_piece = (*m_board)[from];
+  if (mv.is_promo()) 
+  {
+    if (flags == Move::KNIGHT_PROMO || flags == Move::KNIGHT_PROMO_CAPTURE) {
+      score += constants::piece_values[constants::WHITE_KNIGHTS_INDEX]; // just use the white knights because positive value
     }
-    else 
-    {
-      score += perspective * (constants::piece_scores[utils::index_from_pc(mv_piece)][to] - constants::piece_scores[utils::index_from_pc(mv_piece)][from]);
+    else if (flags == Move::BISHOP_PROMO || flags == Move::BISHOP_PROMO_CAPTURE) {
+      score += constants::piece_values[constants::WHITE_BISHOPS_INDEX];
+    }
+    else if (flags == Move::ROOK_PROMO || flags == Move::ROOK_PROMO_CAPTURE) {
+      score += constants::piece_values[constants::WHITE_ROOKS_INDEX];
     }
+    else {
+      score += constants::piece_values[constants::WHITE_QUEENS_INDEX];
+    }
+  }
+  /* check recapturing moves */
+  if (to == context.recapture_square) 
+  {
+    score += 5 * abs(constants::piece_values[utils::index_from_pc(mv_piece)]); // arbitrary multiplication
+  }
+  else if (mv.is_capture()) {
+    /* captures that hold up in the exchange by the value of the victim, losing ones by how much they lose */
+    int exchange = see(mv);
+    piece tar_piece = (flags == Move::EN_PASSANT_CAPTURE) ? PAWN : (*m_board)[to];
+    score += (exchange >= 0) ? 5 * constants::see_values[PIECE(tar_piece) >> 1] : exchange;
+  }
+  /* score moves to squares attacked by pawns */
+  else if(PIECE(mv_piece) != PAWN && is_attacked_by_pawn(to)) 
+    score -= abs(constants::piece_values[utils::index_from_pc(mv_piece)]); // can play around with this
+  
+  // done for better endgame move ordering of king moves
+  if (PIECE(mv_piece) == KING && m_board->get_piece_bitboard(WHITE | QUEEN) == 0 && m_board->get_piece_bitboard(BLACK | QUEEN) == 0)
+  {
+    score += perspective * (constants::piece_scores[utils::index_from_pc(mv_piece) + 2][to] - constants::piece_scores[utils::index_from_pc(mv_piece) + 2][from]);
+  }
+  else 
+  {
+    score += perspective * (constants::piece_scores[utils::index_from_pc(mv_piece)][to] - constants::piece_scores[utils::index_from_pc(mv_piece)][from]);
+  }
 
-    if(flags == Move::QUIET_MOVE) {
-      score -= 10000; /* try quiet moves last even behind bad captures */
-      if (ply_from_root.has_value() && is_killer(ply_from_root.value(), mv))
+  if(!mv.is_capture() && !mv.is_promo()) { // the same moves the search counts as quiets, double pushes and castles included
+    score -= 10000; /* try quiet moves last even behind bad captures */
+    if (context.ply_from_root.has_value())
+    {
+      /* killers never get here, the move picker hands them out before generating the quiets */
+      if (mv == context.counter_move)
       {
-        score += 5000; // consider killers higher
+        score += 4000; // refuted the opponent's last move elsewhere in the tree
       }
 
-    }     
-    mv.set_score(score);
+      int history = m_history[m_board->is_white_turn() ? WHITE : BLACK][from][to];
+      int pc_index = utils::index_from_pc(mv_piece);
+      for (const PieceToHistory* continuation : context.continuations)
+      {
+        history += continuation ? (*continuation)[pc_index][to] : 0;
+      }
+      score += history / constants::HISTORY_ORDER_DIVISOR; // stays inside the counter move bonus
+    }
   }
-  std::sort(moves.begin(), moves.end(), [](Move mv1, Move mv2) { return mv1.score() > mv2.score(); });
+  return score;
 }
 
 std::string MoveGenerator::notation_from_move(Move move) const
 {
-  std::vector<Move> all_moves;
+  MoveList all_moves;
   generate_moves(all_moves);
   // conflicting doesn't work for knights right now
   // need to update for check (+) and checkmate (#)
   // need to add castling
-  std::vector<Move> conflicting_moves;
+  MoveList conflicting_moves;
   for (Move single_move : all_moves) 
   {
     if (single_move.to() == move.to() && 
@@ -240,7 +461,7 @@ Move MoveGenerator::move_from_notation(std::string notation) const
     std::exit(-1);
   }
   notation.erase(remove(notation.begin(), notation.end(), '+'), notation.end());
-  std::vector<Move> moves;
+  MoveList moves;
   generate_moves(moves);
   // this is so ugly
   if(notation == "O-O") {
@@ -400,7 +621,7 @@ Move MoveGenerator::move_from_long_algebraic(std::string notation) const
     }
   }
 
-  std::vector<Move> moves;
+  MoveList moves;
   generate_moves(moves);
 
   for (Move move : moves)
@@ -421,193 +642,21 @@ Move MoveGenerator::move_from_long_algebraic(std::string notation) const
   return Move::NO_MOVE;
 }
 
-void MoveGenerator::sort_by_long_algebraic_notation(std::vector<Move>& moves) const
+void MoveGenerator::sort_by_long_algebraic_notation(MoveList& moves) const
 {
-  sort(moves.begin(), moves.end(), 
+  moves.sort(
       [this](Move a, Move b) {
         return move_to_long_algebraic(a) < move_to_long_algebraic(b);
       } 
   );
 }
 
-MoveGenerator::Pin MoveGenerator::get_pinned_pieces(int friendly_king_loc) const
-{
-  Pin pin;
-  pin.pinned_pieces = 0;
-  bitboard curr_pin;
-  int pinned_piece_loc;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  bitboard friendly_pieces;
-  if(m_board->is_white_turn()) {
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-    friendly_pieces = m_board->get_white_pieces();
-  }
-  else {
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-    friendly_pieces = m_board->get_black_pieces();
-  }
-  bitboard king_rook_attacks = lut.get_rook_attacks(friendly_king_loc, m_board->get_all_pieces());
-  bitboard king_bishop_attacks = lut.get_bishop_attacks(friendly_king_loc, m_board->get_all_pieces());
-  bitboard rook_attacks;
-  bitboard bishop_attacks;
-  bitboard queen_attacks;
-  int pc_loc;
-  int pc_rank;
-  int pc_file;
-  int pc_diag;
-  int pc_antidiag;
-  int king_rank = utils::rank(friendly_king_loc);
-  int king_file = utils::file(friendly_king_loc);
-  int king_diag = king_rank - king_file;
-  int king_antidiag = king_rank + king_file;
-  while(opponent_rooks) {
-    pc_loc = first_set_bit(opponent_rooks);
-    pc_rank = utils::rank(pc_loc);
-    pc_file = utils::file(pc_loc);
-    if(!(pc_rank == king_rank || pc_file == king_file)) {
-      REMOVE_FIRST(opponent_rooks);
-      continue;
-    }
-    rook_attacks = lut.get_rook_attacks(pc_loc, m_board->get_all_pieces());
-    curr_pin = rook_attacks & king_rook_attacks & friendly_pieces;
-    if(curr_pin){
-      pin.pinned_pieces |= curr_pin;
-      pinned_piece_loc = first_set_bit(curr_pin);
-      pin.ray_at_sq[pinned_piece_loc] = lut.get_ray_from_rook_to_king(pc_loc, friendly_king_loc);
-    }
-    REMOVE_FIRST(opponent_rooks);
-  }
-  while(opponent_bishops) {
-    pc_loc = first_set_bit(opponent_bishops);
-    pc_rank = utils::rank(pc_loc);
-    pc_file = utils::file(pc_loc);
-    pc_diag = pc_rank - pc_file;
-    pc_antidiag = pc_rank + pc_file;
-    if(!(pc_diag == king_diag || pc_antidiag == king_antidiag)) {
-      REMOVE_FIRST(opponent_bishops);
-      continue;
-    }
-    bishop_attacks = lut.get_bishop_attacks(pc_loc, m_board->get_all_pieces());
-    curr_pin = bishop_attacks & king_bishop_attacks & friendly_pieces;
-    if(curr_pin){
-      pin.pinned_pieces |= curr_pin;
-      pinned_piece_loc = first_set_bit(curr_pin);
-      pin.ray_at_sq[pinned_piece_loc] = lut.get_ray_from_bishop_to_king(pc_loc, friendly_king_loc);
-    }
-    REMOVE_FIRST(opponent_bishops);
-  }
-  while(opponent_queens) {
-    pc_loc = first_set_bit(opponent_queens);
-    pc_rank = utils::rank(pc_loc);
-    pc_file = utils::file(pc_loc);
-    pc_diag = pc_rank - pc_file;
-    pc_antidiag = pc_rank + pc_file;
-    if(pc_rank == king_rank || pc_file == king_file) {
-      queen_attacks = lut.get_rook_attacks(pc_loc, m_board->get_all_pieces());
-      curr_pin = queen_attacks & king_rook_attacks & friendly_pieces;
-      if(curr_pin){
-        pin.pinned_pieces |= curr_pin;
-        pinned_piece_loc = first_set_bit(curr_pin);
-        pin.ray_at_sq[pinned_piece_loc] = lut.get_ray_from_rook_to_king(pc_loc, friendly_king_loc);
-      }
-    }
-    else if(pc_diag == king_diag || pc_antidiag == king_antidiag){
-      queen_attacks = lut.get_bishop_attacks(pc_loc, m_board->get_all_pieces());
-      curr_pin = queen_attacks & king_bishop_attacks & friendly_pieces;
-      if(curr_pin){
-        pin.pinned_pieces |= curr_pin;
-        pinned_piece_loc = first_set_bit(curr_pin);
-        pin.ray_at_sq[pinned_piece_loc] = lut.get_ray_from_bishop_to_king(pc_loc, friendly_king_loc);
-      }
-    }
-    REMOVE_FIRST(opponent_queens);
-  }
-  return pin;
-}
-
-bitboard MoveGenerator::checking_pieces() const
+bitboard MoveGenerator::get_check_mask(bitboard checkers) const
 {
-  int friendly_king = (m_board->is_white_turn()) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
-  Move last_move = m_board->get_last_move();
-  if(last_move.is_no_move()) {
-    return attackers_from_square(friendly_king);
-  }
-  bool discovered_check = false;
-
-  int to = last_move.to();
-  int from = last_move.from();
-  int type = last_move.type();
-
-  bitboard checkers = 0;
-
-  piece moved_piece = (*m_board)[to];
-  bitboard piece_bit = BIT_FROM_SQ(to);
-  switch (PIECE(moved_piece)) {
-    case PAWN:
-      checkers = lut.get_pawn_attacks(friendly_king, m_board->is_white_turn()) & piece_bit;
-      break;
-    case KNIGHT:
-      checkers = lut.get_knight_attacks(friendly_king) & piece_bit;
-      break;
-    case BISHOP:
-      checkers = lut.get_bishop_attacks(friendly_king, m_board->get_all_pieces()) & piece_bit;
-      break;
-    case ROOK:
-      checkers = lut.get_rook_attacks(friendly_king, m_board->get_all_pieces()) & piece_bit;
-      break;
-    case QUEEN:
-      checkers = lut.get_queen_attacks(friendly_king, m_board->get_all_pieces()) & piece_bit;
-      break;
-    case KING:
-      break; /* the king can never move to check the other king */
-  }
-
-  /* there is no possibility for a discovered check here */
-  if(type == Move::QUIET_MOVE || type == Move::DOUBLE_PUSH || type == Move::NORMAL_CAPTURE) {
-    if(utils::rank(from) != utils::rank(friendly_king) && utils::file(from) != utils::file(friendly_king) &&
-       utils::diag(from) != utils::diag(friendly_king) && utils::anti_diag(from) != utils::anti_diag(friendly_king))
-       return checkers;
-  }
-
-
-  bitboard opponent_bishops;
-  bitboard opponent_rooks;
-  bitboard opponent_queens;
-
-  if(m_board->is_white_turn()) {
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  bitboard diagonal_sliders = opponent_bishops | opponent_queens;
-  bitboard cardinal_sliders = opponent_rooks | opponent_queens;
-
-  /* remove the piece that was moved to not double check it */
-  diagonal_sliders &= ~BIT_FROM_SQ(to);
-  cardinal_sliders &= ~BIT_FROM_SQ(to);
-
-  bitboard bishop_from_king = lut.get_bishop_attacks(friendly_king, m_board->get_all_pieces());
-  bitboard attacking_diagonal = bishop_from_king & diagonal_sliders;
-  checkers |= attacking_diagonal;
-  if(attacking_diagonal)
-    discovered_check = true;
-
-  if(!discovered_check){
-    bitboard rook_from_king = lut.get_rook_attacks(friendly_king, m_board->get_all_pieces());
-    checkers |= rook_from_king & cardinal_sliders;
-  }
-  return checkers;
+  if(!checkers) return 0xFFFFFFFFFFFFFFFF;
+  /* in single check we can either capture the checking piece or block a sliding one */
+  int friendly_king_loc = (m_board->is_white_turn()) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  return checkers | LookUpTable::get_between(friendly_king_loc, first_set_bit(checkers)); // nothing is between a king and a pawn or knight
 }
 
 MoveGenerator::CheckType MoveGenerator::check_type(bitboard checkers) const
@@ -618,46 +667,150 @@ MoveGenerator::CheckType MoveGenerator::check_type(bitboard checkers) const
   return CheckType::DOUBLE;
 }
 
-bool MoveGenerator::in_check() const
+int MoveGenerator::see(Move move) const
 {
-  return check_type(checking_pieces()) != CheckType::NONE;
-}
+  int from = move.from();
+  int to = move.to();
+  bitboard occupied = m_board->get_all_pieces();
+  piece attacker = (*m_board)[from];
+  int gain[32];
+  int d = 0;
 
-int MoveGenerator::see(int sq) const
-{
-  int value = 0;
-  int attacker_sq = least_valued_attacker_sq(sq, !m_board->is_white_turn());
-  if(attacker_sq != constants::NONE) {
-    Move capture{attacker_sq, sq, Move::NORMAL_CAPTURE}; /* would this also work for promotions? */
-    piece captured_piece = (*m_board)[sq];
-    m_board->make_move(capture);
-    value = std::max(0, abs(constants::piece_values[utils::index_from_pc(captured_piece)]) - see(sq));
-    m_board->unmake_move(capture);
-  }
-  return value;
-}
+  gain[0] = constants::see_values[PIECE((*m_board)[to]) >> 1];
+  if (move.type() == Move::EN_PASSANT_CAPTURE)
+  {
+    gain[0] = constants::see_values[PAWN >> 1];
+    occupied ^= BIT_FROM_SQ((utils::rank(from) * 8 + utils::file(to))); // the captured pawn is beside us, not on to
+  }
+
+  bitboard diagonal_sliders = m_board->get_piece_bitboard(WHITE | BISHOP) | m_board->get_piece_bitboard(BLACK | BISHOP) | 
+                              m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN);
+  bitboard straight_sliders = m_board->get_piece_bitboard(WHITE | ROOK) | m_board->get_piece_bitboard(BLACK | ROOK) | 
+                              m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN);
+  bitboard attackers = attackers_to(to, occupied);
+  bitboard from_bb = BIT_FROM_SQ(from);
+  int side = COLOR(attacker);
+
+  /*
+    Swap list: gain[d] is what the side capturing at depth d has won if the exchange stops right
+    after its capture. It is filled in speculatively, assuming the piece that just landed on to
+    gets taken next, and then negamaxed back down once nobody can recapture.
+  */
+  do
+  {
+    d++;
+    gain[d] = constants::see_values[PIECE(attacker) >> 1] - gain[d - 1];
+
+    occupied ^= from_bb;
+    /* whatever was behind the piece that just captured can now see the square */
+    attackers |= (lut.get_bishop_attacks(to, occupied) & diagonal_sliders) | (lut.get_rook_attacks(to, occupied) & straight_sliders);
+    attackers &= occupied;
+    side ^= 1;
+
+    bitboard side_attackers = attackers & (side == WHITE ? m_board->get_white_pieces() : m_board->get_black_pieces());
+    from_bb = 0;
+    for (piece pc = PAWN; pc <= KING && side_attackers; pc += 2)
+    {
+      bitboard candidates = side_attackers & m_board->get_piece_bitboard(side | pc);
+      if (candidates)
+      {
+        from_bb = candidates & -candidates;
+        attacker = side | pc;
+        break;
+      }
+    }
+    /* the king can only take last, recapturing into a defended square is illegal */
+    if (PIECE(attacker) == KING && (attackers & ~side_attackers))
+    {
+      from_bb = 0;
+    }
+  } while (from_bb && d < 31);
 
-int MoveGenerator::see_capture(Move capture) const
-{
-  int value = 0;
-  int to = capture.to();
-  piece cap_piece = (*m_board)[to];
-  m_board->make_move(capture);
-  value = std::abs(constants::piece_values[utils::index_from_pc(cap_piece)]) - see(to);
-  m_board->unmake_move(capture);
-  return value;
+  while (--d)
+  {
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+  }
+  return gain[0];
 }
 
-bool MoveGenerator::is_bad_capture(Move capture) const
+bool MoveGenerator::see_ge(Move move, int threshold) const
 {
-  piece mv_piece = (*m_board)[capture.from()];
-  piece cap_piece = (*m_board)[capture.to()];
-  /* if we are capturing a piece of higher material, its probably good */
-  if(abs(constants::piece_values[utils::index_from_pc(cap_piece)]) 
-     - abs(constants::piece_values[utils::index_from_pc(mv_piece)]) > 50) {
-    return false;
-  }
-  return see_capture(capture) < -50;
+  int from = move.from();
+  int to = move.to();
+
+  int swap = constants::see_values[PIECE((*m_board)[to]) >> 1] - threshold;
+  bitboard occupied = m_board->get_all_pieces() ^ BIT_FROM_SQ(from);
+  if (move.type() == Move::EN_PASSANT_CAPTURE)
+  {
+    swap = constants::see_values[PAWN >> 1] - threshold;
+    occupied ^= BIT_FROM_SQ((utils::rank(from) * 8 + utils::file(to)));
+  }
+  if (swap < 0)
+  {
+    return false; // even winning the captured piece for free isn't enough
+  }
+
+  piece attacker = (*m_board)[from];
+  swap = constants::see_values[PIECE(attacker) >> 1] - swap;
+  if (swap <= 0)
+  {
+    return true; // even losing the capturing piece for nothing still clears the threshold
+  }
+
+  bitboard diagonal_sliders = m_board->get_piece_bitboard(WHITE | BISHOP) | m_board->get_piece_bitboard(BLACK | BISHOP) | 
+                              m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN);
+  bitboard straight_sliders = m_board->get_piece_bitboard(WHITE | ROOK) | m_board->get_piece_bitboard(BLACK | ROOK) | 
+                              m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN);
+  bitboard attackers = attackers_to(to, occupied);
+  int side = COLOR(attacker);
+
+  /*
+    swap is how far the side that just captured is above the threshold, flipped each capture.
+    result flips with every capture and is the answer if the side to recapture gives up.
+  */
+  bool result = true;
+  for ( ;; )
+  {
+    side ^= 1;
+    attackers &= occupied;
+    bitboard side_attackers = attackers & (side == WHITE ? m_board->get_white_pieces() : m_board->get_black_pieces());
+    if (!side_attackers)
+    {
+      break;
+    }
+
+    piece pc = PAWN;
+    bitboard candidates = 0;
+    for ( ; pc <= KING; pc += 2)
+    {
+      candidates = side_attackers & m_board->get_piece_bitboard(side | pc);
+      if (candidates) break;
+    }
+
+    if (pc == KING)
+    {
+      /* the king can only take if nothing is left to take it back */
+      return (attackers & ~side_attackers) ? result : !result;
+    }
+
+    result = !result;
+    swap = constants::see_values[pc >> 1] - swap;
+    if (swap < result)
+    {
+      break;
+    }
+
+    occupied ^= candidates & -candidates;
+    if (pc == PAWN || pc == BISHOP || pc == QUEEN)
+    {
+      attackers |= lut.get_bishop_attacks(to, occupied) & diagonal_sliders;
+    }
+    if (pc == ROOK || pc == QUEEN)
+    {
+      attackers |= lut.get_rook_attacks(to, occupied) & straight_sliders;
+    }
+  }
+  return result;
 }
 
 bool MoveGenerator::pawn_promo_or_close_push(Move move) const
@@ -672,24 +825,20 @@ bool MoveGenerator::pawn_promo_or_close_push(Move move) const
   return false;
 }
 
-bitboard MoveGenerator::generate_knight_move_bitboard(int knight_sq, bool captures_only) const
+template <piece Pc>
+bitboard MoveGenerator::piece_attacks(int sq, bitboard occupied) const
 {
-  bitboard knight_attacks = lut.get_knight_attacks(knight_sq);
-  if(captures_only) {
-    bitboard opponent_pieces = (m_board->is_white_turn()) ? m_board->get_black_pieces() : m_board->get_white_pieces();
-    return knight_attacks & opponent_pieces;
-  }
-  bitboard own_pieces = (m_board->is_white_turn()) ? m_board->get_white_pieces() : m_board->get_black_pieces();
-  return knight_attacks & ~own_pieces;
+  if constexpr (Pc == KNIGHT) return lut.get_knight_attacks(sq);
+  if constexpr (Pc == BISHOP) return lut.get_bishop_attacks(sq, occupied);
+  if constexpr (Pc == ROOK)   return lut.get_rook_attacks(sq, occupied);
+  if constexpr (Pc == QUEEN)  return lut.get_queen_attacks(sq, occupied);
+  return lut.get_king_attacks(sq);
 }
 
-bitboard MoveGenerator::generate_king_move_bitboard(int king_sq, bool captures_only) const
+template <piece Us, MoveGenerator::GenType Type>
+bitboard MoveGenerator::generate_king_move_bitboard(int king_sq) const
 {
-  bitboard own_pieces = (m_board->is_white_turn()) ? m_board->get_white_pieces() : m_board->get_black_pieces();
-  bitboard opponent_pieces = (m_board->is_white_turn()) ? m_board->get_black_pieces() : m_board->get_white_pieces();
-  
-  bitboard king_attacks = lut.get_king_attacks(king_sq);
-  bitboard king_pseudomoves = (captures_only) ? (king_attacks & opponent_pieces) : (king_attacks & ~own_pieces);
+  bitboard king_pseudomoves = lut.get_king_attacks(king_sq) & target_squares<Us, Type>();
 
   if(!king_pseudomoves) return 0; // if the king has no pseudolegal moves, it cannot castle
 
@@ -698,449 +847,289 @@ bitboard MoveGenerator::generate_king_move_bitboard(int king_sq, bool captures_o
 
   while(king_pseudomoves) {
     int loc = first_set_bit(king_pseudomoves);
-    if(!is_attacked(loc, blocking_pieces)) king_legal_moves |= BIT_FROM_SQ(loc);
+    if(!is_attacked<Us>(loc, blocking_pieces)) king_legal_moves |= BIT_FROM_SQ(loc);
     REMOVE_FIRST(king_pseudomoves);
   }
 
-  if(captures_only) return king_legal_moves; // you can't castle and capture something
+  /* you can't castle and capture something, or castle out of check */
+  if constexpr (Type == GenType::CAPTURES || Type == GenType::EVASIONS) return king_legal_moves;
 
-  // generate castling moves
-  // maybe move these to defined constants
-  
-  const bitboard w_king_side_castle = 0x40;
-  const bitboard w_queen_side_castle = 0x4;
-  const bitboard b_king_side_castle = 0x4000000000000000;
-  const bitboard b_queen_side_castle = 0x0400000000000000;
-
-  int white_king_sq_1 = constants::F1;
-  int white_king_sq_2 = constants::G1;
-  int white_queen_sq_1 = constants::D1;
-  int white_queen_sq_2 = constants::C1;
-  int white_queen_sq_3 = constants::B1; // this square is allowed to be attacked
-
-  int black_king_sq_1 = constants::F8;
-  int black_king_sq_2 = constants::G8;
-  int black_queen_sq_1 = constants::D8;
-  int black_queen_sq_2 = constants::C8;
-  int black_queen_sq_3 = constants::B8; // this square is allowed to be attacked
+  constexpr bool white = (Us == WHITE);
+  constexpr int king_start = white ? constants::E1 : constants::E8;
+  constexpr int king_side_rook = white ? constants::H1 : constants::H8;
+  constexpr int queen_side_rook = white ? constants::A1 : constants::A8;
+  constexpr int king_side_sq_1 = white ? constants::F1 : constants::F8;
+  constexpr int king_side_sq_2 = white ? constants::G1 : constants::G8;
+  constexpr int queen_side_sq_1 = white ? constants::D1 : constants::D8;
+  constexpr int queen_side_sq_2 = white ? constants::C1 : constants::C8;
+  constexpr int queen_side_sq_3 = white ? constants::B1 : constants::B8; // this square is allowed to be attacked
 
   bitboard king_castle = 0;
-  if(m_board->is_white_turn() && m_board->get_white_king_loc() == constants::E1 && !is_attacked(constants::E1, blocking_pieces)) {
-    if(m_board->can_white_king_side_castle() && (*m_board)[constants::H1] == (WHITE | ROOK)) {
-      if((*m_board)[white_king_sq_1] == EMPTY &&
-         (*m_board)[white_king_sq_2] == EMPTY) {
-           if(!is_attacked(white_king_sq_1, blocking_pieces) &&
-            !is_attacked(white_king_sq_2, blocking_pieces))
-            {
-              king_castle |= w_king_side_castle;
-            }
-            
+  if(king_sq == king_start && !is_attacked<Us>(king_start, blocking_pieces)) {
+    bool can_king_side = white ? m_board->can_white_king_side_castle() : m_board->can_black_king_side_castle();
+    bool can_queen_side = white ? m_board->can_white_queen_side_castle() : m_board->can_black_queen_side_castle();
+
+    if(can_king_side && (*m_board)[king_side_rook] == (Us | ROOK)) {
+      if((*m_board)[king_side_sq_1] == EMPTY &&
+         (*m_board)[king_side_sq_2] == EMPTY) {
+           if(!is_attacked<Us>(king_side_sq_1, blocking_pieces) &&
+              !is_attacked<Us>(king_side_sq_2, blocking_pieces))
+             king_castle |= BIT_FROM_SQ(king_side_sq_2);
          }
     }
 
-    if(m_board->can_white_queen_side_castle() && (*m_board)[constants::A1] == (WHITE | ROOK)) {
-      if((*m_board)[white_queen_sq_1] == EMPTY &&
-         (*m_board)[white_queen_sq_2] == EMPTY &&
-         (*m_board)[white_queen_sq_3] == EMPTY) {
-           if(!is_attacked(white_queen_sq_1, blocking_pieces) &&
-            !is_attacked(white_queen_sq_2, blocking_pieces))
-            king_castle |= w_queen_side_castle;
-         }
-    } 
-  }
-  else if (!m_board->is_white_turn() && m_board->get_black_king_loc() == constants::E8 && !is_attacked(constants::E8, blocking_pieces)) {
-    if(m_board->can_black_king_side_castle() && (*m_board)[constants::H8] == (BLACK | ROOK)) {
-      if((*m_board)[black_king_sq_1] == EMPTY &&
-         (*m_board)[black_king_sq_2] == EMPTY) {
-           if(!is_attacked(black_king_sq_1, blocking_pieces) &&
-            !is_attacked(black_king_sq_2, blocking_pieces))
-            king_castle |= b_king_side_castle;
-         }
-    }
-
-    if(m_board->can_black_queen_side_castle() && (*m_board)[constants::A8] == (BLACK | ROOK)) {
-      if((*m_board)[black_queen_sq_1] == EMPTY &&
-         (*m_board)[black_queen_sq_2] == EMPTY &&
-         (*m_board)[black_queen_sq_3] == EMPTY) {
-           if(!is_attacked(black_queen_sq_1, blocking_pieces) &&
-            !is_attacked(black_queen_sq_2, blocking_pieces))
-            king_castle |= b_queen_side_castle;
+    if(can_queen_side && (*m_board)[queen_side_rook] == (Us | ROOK)) {
+      if((*m_board)[queen_side_sq_1] == EMPTY &&
+         (*m_board)[queen_side_sq_2] == EMPTY &&
+         (*m_board)[queen_side_sq_3] == EMPTY) {
+           if(!is_attacked<Us>(queen_side_sq_1, blocking_pieces) &&
+              !is_attacked<Us>(queen_side_sq_2, blocking_pieces))
+             king_castle |= BIT_FROM_SQ(queen_side_sq_2);
          }
     } 
   }
   return king_legal_moves | king_castle;
 }
 
-bitboard MoveGenerator::generate_pawn_move_bitboard(int pawn_sq, bool captures_only) const
+template <piece Us, MoveGenerator::GenType Type>
+bitboard MoveGenerator::generate_pawn_move_bitboard(int pawn_sq) const
 {
-  bitboard enemy_pieces;
+  constexpr bool white = (Us == WHITE);
+  constexpr piece Them = Us ^ 1;
+  constexpr size_t start_rank = white ? constants::RANK_2 : constants::RANK_7;
+  constexpr int forward = white ? 8 : -8;
+
   bitboard all_pieces = m_board->get_all_pieces();
-  bitboard captures;
-  bitboard forward_moves;
-  bitboard forward_one;
-  bitboard forward_two;
-  bitboard en_passant_capture;
   int en_passant_sq = m_board->get_en_passant_sq();
   bitboard en_passant_bit = 0; // default it to zero
   size_t rank = utils::rank(pawn_sq);
-  bitboard opponent_rooks;
-  bitboard opponent_queens;
-  bitboard attackers;
-  bitboard side_attackers;
-  bitboard board_without_pawns;
-  bitboard white_pawn_attacks;
-  bitboard black_pawn_attacks;
 
   if(en_passant_sq != constants::NONE) {
     en_passant_bit =  BIT_FROM_SQ(en_passant_sq); // used to and with attack pattern
   }
 
-  if(m_board->is_white_turn()) {
-    enemy_pieces = m_board->get_black_pieces();
-    white_pawn_attacks = lut.get_pawn_attacks(pawn_sq, true);
-    captures = white_pawn_attacks & enemy_pieces;
-
-    en_passant_capture = white_pawn_attacks & en_passant_bit;
-    if(en_passant_capture && rank == utils::rank(m_board->get_white_king_loc())){
-      opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-      opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-      board_without_pawns = m_board->get_all_pieces() & ~(BIT_FROM_SQ(pawn_sq)) & ~(en_passant_bit >> 8);
-      attackers = lut.get_rook_attacks(m_board->get_white_king_loc(), board_without_pawns) & (opponent_rooks | opponent_queens);
-      side_attackers = attackers & lut.get_rank_mask(utils::rank(pawn_sq));
-      if(side_attackers) {
-        en_passant_capture = 0;
-      }
-    }
+  bitboard pawn_attacks = lut.get_pawn_attacks(pawn_sq, white);
+  bitboard captures = pawn_attacks & pieces_of<Them>();
 
-    if(captures_only) return captures | en_passant_capture;
-
-    forward_one = lut.get_pawn_pushes(pawn_sq, true) & ~all_pieces;
-    forward_two = 0;
-    if(rank == constants::RANK_2 && forward_one) {
-      forward_two = lut.get_pawn_pushes(pawn_sq + 8, true) & ~all_pieces;
-    }
-    forward_moves = forward_one | forward_two;
+  bitboard en_passant_capture = pawn_attacks & en_passant_bit;
+  if(en_passant_capture && en_passant_uncovers_king<Us>(pawn_sq, en_passant_sq)) {
+    en_passant_capture = 0;
   }
-  else {
-    enemy_pieces = m_board->get_white_pieces();
-    black_pawn_attacks = lut.get_pawn_attacks(pawn_sq, false);
-    captures = black_pawn_attacks & enemy_pieces;
-
-    en_passant_capture = black_pawn_attacks & en_passant_bit;
-    if(en_passant_capture && rank == utils::rank(m_board->get_black_king_loc())){
-      opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-      opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-      board_without_pawns = m_board->get_all_pieces() & ~(BIT_FROM_SQ(pawn_sq)) & ~(en_passant_bit << 8);
-      attackers = lut.get_rook_attacks(m_board->get_black_king_loc(), board_without_pawns) & (opponent_rooks | opponent_queens);
-      side_attackers = attackers & lut.get_rank_mask(utils::rank(pawn_sq));
-      if(side_attackers) {
-        en_passant_capture = 0;
-      }
-    }
 
-    if(captures_only) return captures | en_passant_capture;
+  if constexpr (Type == GenType::CAPTURES) return captures | en_passant_capture;
 
-    forward_one = lut.get_pawn_pushes(pawn_sq, false) & ~all_pieces;
-    forward_two = 0;
-    if(rank == constants::RANK_7 && forward_one) {
-      forward_two = lut.get_pawn_pushes(pawn_sq - 8, false) & ~all_pieces;
-    }
-    forward_moves = forward_one | forward_two;
+  bitboard forward_one = lut.get_pawn_pushes(pawn_sq, white) & ~all_pieces;
+  bitboard forward_two = 0;
+  if(rank == start_rank && forward_one) {
+    forward_two = lut.get_pawn_pushes(pawn_sq + forward, white) & ~all_pieces;
   }
+  bitboard forward_moves = forward_one | forward_two;
+
+  if constexpr (Type == GenType::QUIETS) return forward_moves;
   return captures | forward_moves | en_passant_capture;
 }
 
-bitboard MoveGenerator::generate_rook_move_bitboard(int rook_sq, bool captures_only) const
+template <piece Us, MoveGenerator::GenType Type>
+void MoveGenerator::generate_king_moves(MoveList &curr_moves) const
 {
-  bitboard rook_attacks = lut.get_rook_attacks(rook_sq, m_board->get_all_pieces());
-  if(captures_only) {
-    bitboard opponent_pieces = (m_board->is_white_turn()) ? m_board->get_black_pieces() : m_board->get_white_pieces();
-    return rook_attacks & opponent_pieces;
+  int from = (Us == WHITE) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  bitboard opponent_pieces = pieces_of<Us ^ 1>();
+  bitboard king_moves = generate_king_move_bitboard<Us, Type>(from);
+  while(king_moves) {
+    int to = first_set_bit(king_moves);
+    if(to - from == 2) { // king side castle
+      curr_moves.push_back(Move{from, to, Move::KING_SIDE_CASTLE});
+    }
+    else if (to - from == -2) { // queen side castle
+      curr_moves.push_back(Move{from, to, Move::QUEEN_SIDE_CASTLE});
+    } 
+    else if constexpr (Type == GenType::CAPTURES) {
+      curr_moves.push_back(Move{from, to, Move::NORMAL_CAPTURE});
+    }
+    else if constexpr (Type == GenType::QUIETS) {
+      curr_moves.push_back(Move{from, to, Move::QUIET_MOVE});
+    }
+    else {
+      curr_moves.push_back(Move{from, to, (BIT_FROM_SQ(to) & opponent_pieces) ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE});
+    }
+    REMOVE_FIRST(king_moves);
   }
-  bitboard own_pieces = (m_board->is_white_turn()) ? m_board->get_white_pieces() : m_board->get_black_pieces();
-  return rook_attacks & ~own_pieces;
 }
 
-bitboard MoveGenerator::generate_bishop_move_bitboard(int bishop_sq, bool captures_only) const
+template <piece Us, piece Pc, MoveGenerator::GenType Type>
+void MoveGenerator::generate_piece_moves(MoveList &curr_moves, bitboard check_mask, bitboard pinned) const
 {
-  bitboard bishop_attacks = lut.get_bishop_attacks(bishop_sq, m_board->get_all_pieces());
-  if(captures_only) {
-    bitboard opponent_pieces = (m_board->is_white_turn()) ? m_board->get_black_pieces() : m_board->get_white_pieces();
-    return bishop_attacks & opponent_pieces;
+  bitboard pieces = m_board->get_piece_bitboard(Us | Pc);
+  bitboard opponent_pieces = pieces_of<Us ^ 1>();
+  bitboard all_pieces = m_board->get_all_pieces();
+  bitboard targets = target_squares<Us, Type>() & check_mask;
+  int king_sq = (Us == WHITE) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  if constexpr (Pc == KNIGHT) {
+    pieces &= ~pinned; // pinned knights cannot move at all
   }
-  bitboard own_pieces = (m_board->is_white_turn()) ? m_board->get_white_pieces() : m_board->get_black_pieces();
-  return bishop_attacks & ~own_pieces;
-}
-
-bitboard MoveGenerator::generate_queen_move_bitboard(int queen_sq, bool captures_only) const
-{
-  return generate_rook_move_bitboard(queen_sq, captures_only)
-       | generate_bishop_move_bitboard(queen_sq, captures_only);
-}
 
+  while(pieces) {
+    int from = first_set_bit(pieces);
+    bitboard moves = piece_attacks<Pc>(from, all_pieces) & targets;
+    if(BIT_FROM_SQ(from) & pinned) moves &= LookUpTable::get_line(king_sq, from); // stay between the king and the pinner
 
-void MoveGenerator::generate_king_moves(std::vector<Move> &curr_moves, bool captures_only) const
-{
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard kings;
-  bitboard opponent_pieces;
-  if (m_board->is_white_turn()) {
-    kings = m_board->get_piece_bitboard(WHITE | KING);
-    opponent_pieces = m_board->get_black_pieces();
-  }
-  else {
-    kings = m_board->get_piece_bitboard(BLACK | KING);
-    opponent_pieces = m_board->get_white_pieces();
-  }
-  bitboard king_moves;
-  while(kings) {
-    from = first_set_bit(kings);
-    king_moves = generate_king_move_bitboard(from, captures_only);
-    while(king_moves) {
-      to = first_set_bit(king_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to - from == 2) { // king side castle
-        curr_moves.push_back(Move{from, to, Move::KING_SIDE_CASTLE});
+    while(moves) {
+      int to = first_set_bit(moves);
+      if constexpr (Type == GenType::CAPTURES) {
+        curr_moves.push_back(Move{from, to, Move::NORMAL_CAPTURE});
       }
-      else if (to - from == -2) { // queen side castle
-        curr_moves.push_back(Move{from, to, Move::QUEEN_SIDE_CASTLE});
-      } 
-      else{
-        if(to_bit & opponent_pieces) flags = Move::NORMAL_CAPTURE;
-        else                         flags = Move::QUIET_MOVE;
-        curr_moves.push_back(Move{from, to, flags});
+      else if constexpr (Type == GenType::QUIETS) {
+        curr_moves.push_back(Move{from, to, Move::QUIET_MOVE});
       }
-      
-      REMOVE_FIRST(king_moves);
+      else {
+        curr_moves.push_back(Move{from, to, (BIT_FROM_SQ(to) & opponent_pieces) ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE});
+      }
+      REMOVE_FIRST(moves);
     }
-    REMOVE_FIRST(kings);
+    REMOVE_FIRST(pieces);
   }
 }
 
-void MoveGenerator::generate_knight_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only) const
+/* adds a move to every target square from the square Offset behind it */
+template <int Offset>
+static void add_pawn_moves(MoveList &curr_moves, bitboard targets, int flags)
 {
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard knights;
-  bitboard opponent_pieces;
-  if (m_board->is_white_turn()) {
-    knights = m_board->get_piece_bitboard(WHITE | KNIGHT);
-    opponent_pieces = m_board->get_black_pieces();
-  }
-  else {
-    knights = m_board->get_piece_bitboard(BLACK | KNIGHT);
-    opponent_pieces = m_board->get_white_pieces();
-  }
-  bitboard knight_moves;
-  bitboard knight_bit;
-  while(knights) {
-    from = first_set_bit(knights);
-    knight_bit = BIT_FROM_SQ(from);
-    if(knight_bit & pin.pinned_pieces) {
-      REMOVE_FIRST(knights);
-      continue;
-    } // pinned knights cannot move at all
-    knight_moves = generate_knight_move_bitboard(from, captures_only) & check_mask;
-    
-    while(knight_moves) {
-      to = first_set_bit(knight_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to_bit & opponent_pieces) flags = Move::NORMAL_CAPTURE;
-      else                         flags = Move::QUIET_MOVE;
-      curr_moves.push_back(Move{from, to, flags});
-      REMOVE_FIRST(knight_moves);
-    }
-    REMOVE_FIRST(knights);
+  while(targets) {
+    int to = first_set_bit(targets);
+    curr_moves.push_back(Move{to - Offset, to, flags});
+    REMOVE_FIRST(targets);
   }
 }
 
-void MoveGenerator::generate_pawn_moves(std::vector<Move> &curr_moves, bitboard check_mask, bool pawn_check, Pin &pin, bool captures_only) const
+static void add_promotions(MoveList &curr_moves, int from, int to, bool capture)
 {
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard pin_mask;
-  bitboard pawns;
-  bitboard opponent_pieces; // used for captures only
-  if (m_board->is_white_turn()) {
-    pawns = m_board->get_piece_bitboard(WHITE | PAWN);
-    opponent_pieces = m_board->get_black_pieces();
+  curr_moves.push_back(Move{from, to, capture ? Move::KNIGHT_PROMO_CAPTURE : Move::KNIGHT_PROMO});
+  curr_moves.push_back(Move{from, to, capture ? Move::BISHOP_PROMO_CAPTURE : Move::BISHOP_PROMO});
+  curr_moves.push_back(Move{from, to, capture ? Move::ROOK_PROMO_CAPTURE : Move::ROOK_PROMO});
+  curr_moves.push_back(Move{from, to, capture ? Move::QUEEN_PROMO_CAPTURE : Move::QUEEN_PROMO});
+}
+
+template <int Offset, bool Capture>
+static void add_promotions(MoveList &curr_moves, bitboard targets)
+{
+  while(targets) {
+    int to = first_set_bit(targets);
+    add_promotions(curr_moves, to - Offset, to, Capture);
+    REMOVE_FIRST(targets);
   }
-  else {
-    pawns = m_board->get_piece_bitboard(BLACK | PAWN);
-    opponent_pieces = m_board->get_white_pieces();
+}
+
+template <piece Us, MoveGenerator::GenType Type>
+void MoveGenerator::generate_pawn_moves(MoveList &curr_moves, bitboard check_mask, bool pawn_check, bitboard pinned) const
+{
+  constexpr bool white = (Us == WHITE);
+  constexpr piece Them = Us ^ 1;
+  constexpr int up = white ? 8 : -8;
+  constexpr int up_left = white ? 7 : -9; // towards the a file
+  constexpr int up_right = white ? 9 : -7; // towards the h file
+  constexpr bitboard double_push_rank = rank_bb(white ? constants::RANK_3 : constants::RANK_6); // where a single push can push again from
+  constexpr bitboard promo_rank = rank_bb(white ? constants::RANK_8 : constants::RANK_1);
+  constexpr size_t last_rank = white ? constants::RANK_8 : constants::RANK_1;
+
+  bitboard all_pawns = m_board->get_piece_bitboard(Us | PAWN);
+  bitboard opponent_pieces = pieces_of<Them>();
+  bitboard empty = ~m_board->get_all_pieces();
+
+  /* 
+    Unpinned pawns all move the same way, so shift them together and pick the from square back out
+    of the shift. Pinned pawns are rare and each one has its own line, they go one at a time below.
+  */
+  bitboard pawns = all_pawns & ~pinned;
+
+  if constexpr (Type != GenType::CAPTURES) {
+    bitboard single_pushes = shift<up>(pawns) & empty;
+    bitboard double_pushes = shift<up>(single_pushes & double_push_rank) & empty & check_mask;
+    single_pushes &= check_mask;
+    add_pawn_moves<up>(curr_moves, single_pushes & ~promo_rank, Move::QUIET_MOVE);
+    add_pawn_moves<2 * up>(curr_moves, double_pushes, Move::DOUBLE_PUSH);
+    add_promotions<up, false>(curr_moves, single_pushes & promo_rank);
   }
 
-  bitboard pawn_moves;
-  bitboard pawn_bit;
   bitboard en_passant_bit = 0;
-  if(m_board->get_en_passant_sq() != constants::NONE) {
-    en_passant_bit = BIT_FROM_SQ(m_board->get_en_passant_sq());
+  int en_passant_sq = m_board->get_en_passant_sq();
+  if(en_passant_sq != constants::NONE) {
+    en_passant_bit = BIT_FROM_SQ(en_passant_sq);
     if(pawn_check) {
-      check_mask |= en_passant_bit;
+      check_mask |= en_passant_bit; // taking en passant removes the checking pawn without landing on it
     }
   }
-  while(pawns) {
-    from = first_set_bit(pawns);
-    pawn_bit = BIT_FROM_SQ(from);
-    pin_mask = 0xFFFFFFFFFFFFFFFF;
-    if(pawn_bit & pin.pinned_pieces) pin_mask = pin.ray_at_sq[from];
-    pawn_moves = generate_pawn_move_bitboard(from, captures_only) & check_mask & pin_mask;
-    while(pawn_moves) {
-      to = first_set_bit(pawn_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to_bit & en_passant_bit)         flags = Move::EN_PASSANT_CAPTURE;
-      else if(to_bit & opponent_pieces)   flags = Move::NORMAL_CAPTURE;
-      else                                flags = Move::QUIET_MOVE;
-      int to_rank = utils::rank(to);
-      if(to_rank == constants::RANK_8 || to_rank == constants::RANK_1) {
-        if(utils::file(to) != utils::file(from)) {
-          curr_moves.push_back(Move{from, to, Move::KNIGHT_PROMO_CAPTURE}); // or this on to flag because we check for captures prior to this
-          curr_moves.push_back(Move{from, to, Move::BISHOP_PROMO_CAPTURE});
-          curr_moves.push_back(Move{from, to, Move::ROOK_PROMO_CAPTURE});
-          curr_moves.push_back(Move{from, to, Move::QUEEN_PROMO_CAPTURE});
-        }
-        else {
-          curr_moves.push_back(Move{from, to, Move::KNIGHT_PROMO});
-          curr_moves.push_back(Move{from, to, Move::BISHOP_PROMO});
-          curr_moves.push_back(Move{from, to, Move::ROOK_PROMO});
-          curr_moves.push_back(Move{from, to, Move::QUEEN_PROMO});
+
+  if constexpr (Type != GenType::QUIETS) {
+    bitboard targets = opponent_pieces & check_mask;
+    bitboard left_captures = shift<up_left>(pawns) & targets;
+    bitboard right_captures = shift<up_right>(pawns) & targets;
+    add_pawn_moves<up_left>(curr_moves, left_captures & ~promo_rank, Move::NORMAL_CAPTURE);
+    add_pawn_moves<up_right>(curr_moves, right_captures & ~promo_rank, Move::NORMAL_CAPTURE);
+    add_promotions<up_left, true>(curr_moves, left_captures & promo_rank);
+    add_promotions<up_right, true>(curr_moves, right_captures & promo_rank);
+
+    if(en_passant_bit & check_mask) {
+      /* at most two pawns can take en passant, the pawns of ours a pawn of theirs on the square would attack */
+      bitboard capturers = lut.get_pawn_attacks(en_passant_sq, !white) & pawns;
+      while(capturers) {
+        int from = first_set_bit(capturers);
+        if(!en_passant_uncovers_king<Us>(from, en_passant_sq)) {
+          curr_moves.push_back(Move{from, en_passant_sq, Move::EN_PASSANT_CAPTURE});
         }
-        
+        REMOVE_FIRST(capturers);
+      }
+    }
+  }
+
+  bitboard pinned_pawns = all_pawns & pinned;
+  int king_sq = white ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  while(pinned_pawns) {
+    int from = first_set_bit(pinned_pawns);
+    bitboard pawn_moves = generate_pawn_move_bitboard<Us, Type>(from) & check_mask & LookUpTable::get_line(king_sq, from);
+    while(pawn_moves) {
+      int to = first_set_bit(pawn_moves);
+      bitboard to_bit = BIT_FROM_SQ(to);
+      bool capture = utils::file(to) != utils::file(from);
+      if(utils::rank(to) == last_rank) {
+        add_promotions(curr_moves, from, to, capture);
       }
-      else if (abs(from - to) == 16) { // double pawn push
+      else if(to_bit & en_passant_bit) {
+        curr_moves.push_back(Move{from, to, Move::EN_PASSANT_CAPTURE});
+      }
+      else if(abs(from - to) == 16) { // double pawn push
         curr_moves.push_back(Move{from, to, Move::DOUBLE_PUSH});
       }
       else {
-        curr_moves.push_back(Move{from, to, flags}); // should already be set to quiet or capture
+        curr_moves.push_back(Move{from, to, capture ? Move::NORMAL_CAPTURE : Move::QUIET_MOVE});
       }
       REMOVE_FIRST(pawn_moves);
     }
-    REMOVE_FIRST(pawns);
+    REMOVE_FIRST(pinned_pawns);
   }
 }
 
-void MoveGenerator::generate_rook_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only) const
+template <piece Us>
+bool MoveGenerator::en_passant_uncovers_king(int from, int en_passant_sq) const
 {
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard pin_mask;
-  bitboard rooks;
-  bitboard opponent_pieces;
-  if (m_board->is_white_turn()) {
-    rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_pieces = m_board->get_black_pieces();
-  }
-  else {
-    rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_pieces = m_board->get_white_pieces();
-  }
-
-  bitboard rook_moves;
-  bitboard rook_bit;
-  while(rooks) {
-    from = first_set_bit(rooks);
-    rook_bit = BIT_FROM_SQ(from);
-    pin_mask = 0xFFFFFFFFFFFFFFFF;
-    if(rook_bit & pin.pinned_pieces) pin_mask = pin.ray_at_sq[from];
-    rook_moves = generate_rook_move_bitboard(from, captures_only) & check_mask & pin_mask;
-
-    while(rook_moves) {
-      to = first_set_bit(rook_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to_bit & opponent_pieces) flags = Move::NORMAL_CAPTURE;
-      else                         flags = Move::QUIET_MOVE;
-      curr_moves.push_back(Move{from, to, flags});
-      REMOVE_FIRST(rook_moves);
-    }
-    REMOVE_FIRST(rooks);
-  }
+  int king_loc = (Us == WHITE) ? m_board->get_white_king_loc() : m_board->get_black_king_loc();
+  size_t rank = utils::rank(from);
+  if(rank != utils::rank(king_loc)) return false;
+
+  /* taking en passant removes two pawns from the king's rank at once, which can expose it to a rook */
+  constexpr piece Them = Us ^ 1;
+  bitboard captured_pawn = (Us == WHITE) ? BIT_FROM_SQ(en_passant_sq - 8) : BIT_FROM_SQ(en_passant_sq + 8);
+  bitboard board_without_pawns = m_board->get_all_pieces() & ~BIT_FROM_SQ(from) & ~captured_pawn;
+  bitboard attackers = lut.get_rook_attacks(king_loc, board_without_pawns) & 
+                       (m_board->get_piece_bitboard(Them | ROOK) | m_board->get_piece_bitboard(Them | QUEEN));
+  return (attackers & lut.get_rank_mask(rank)) != 0;
 }
 
-void MoveGenerator::generate_bishop_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only) const
+template <piece Us, MoveGenerator::GenType Type>
+bitboard MoveGenerator::target_squares() const
 {
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard pin_mask;
-  bitboard bishops;
-  bitboard opponent_pieces;
-  if (m_board->is_white_turn()) {
-    bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_pieces = m_board->get_black_pieces();
-  }
-  else {
-    bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_pieces = m_board->get_white_pieces();
-  }
-
-  bitboard bishop_moves;
-  bitboard bishop_bit;
-  while(bishops) {
-    from = first_set_bit(bishops);
-    bishop_bit = BIT_FROM_SQ(from);
-    pin_mask = 0xFFFFFFFFFFFFFFFF;
-    if(bishop_bit & pin.pinned_pieces) pin_mask = pin.ray_at_sq[from];
-    bishop_moves = generate_bishop_move_bitboard(from, captures_only) & check_mask & pin_mask;
-    
-    while(bishop_moves) {
-      to = first_set_bit(bishop_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to_bit & opponent_pieces) flags = Move::NORMAL_CAPTURE;
-      else                         flags = Move::QUIET_MOVE;
-      curr_moves.push_back(Move{from, to, flags});
-      REMOVE_FIRST(bishop_moves);
-    }
-    REMOVE_FIRST(bishops);
-  }
-}
-
-void MoveGenerator::generate_queen_moves(std::vector<Move> &curr_moves, bitboard check_mask, Pin &pin, bool captures_only) const
-{
-  int from;
-  int to;
-  int flags;
-  bitboard to_bit;
-  bitboard pin_mask;
-  bitboard queens;
-  bitboard opponent_pieces;
-  if (m_board->is_white_turn()) {
-    queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-    opponent_pieces = m_board->get_black_pieces();
-  }
-  else {
-    queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-    opponent_pieces = m_board->get_white_pieces();
-  }
-
-  bitboard queen_moves;
-  bitboard queen_bit;
-  while(queens) {
-    from = first_set_bit(queens);
-    queen_bit = BIT_FROM_SQ(from);
-    pin_mask = 0xFFFFFFFFFFFFFFFF;
-    if(queen_bit & pin.pinned_pieces) pin_mask = pin.ray_at_sq[from];
-    queen_moves = generate_queen_move_bitboard(from, captures_only) & check_mask & pin_mask;
-    
-    while(queen_moves) {
-      to = first_set_bit(queen_moves);
-      to_bit = BIT_FROM_SQ(to);
-      if(to_bit & opponent_pieces) flags = Move::NORMAL_CAPTURE;
-      else                         flags = Move::QUIET_MOVE;
-      curr_moves.push_back(Move{from, to, flags});
-      REMOVE_FIRST(queen_moves);
-    }
-    REMOVE_FIRST(queens);
-  }
+  if constexpr (Type == GenType::CAPTURES) return pieces_of<Us ^ 1>();
+  if constexpr (Type == GenType::QUIETS) return ~m_board->get_all_pieces();
+  return ~pieces_of<Us>(); // the check mask narrows evasions down further
 }
 
 bitboard MoveGenerator::generate_attack_map(bool white_side) const
@@ -1190,72 +1179,17 @@ bitboard MoveGenerator::generate_attack_map(bool white_side) const
   return attack_map;
 }
 
-piece MoveGenerator::least_valued_attacker(int sq) const
+bitboard MoveGenerator::attackers_to(int sq, bitboard occupied) const
 {
-  bitboard opponent_knights;
-  bitboard opponent_pawns;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  if(m_board->is_white_turn()) {
-    opponent_knights = m_board->get_piece_bitboard(BLACK | KNIGHT);
-    opponent_pawns = m_board->get_piece_bitboard(BLACK | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_knights = m_board->get_piece_bitboard(WHITE | KNIGHT);
-    opponent_pawns = m_board->get_piece_bitboard(WHITE | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  if(lut.get_pawn_attacks(sq, m_board->is_white_turn()) & opponent_pawns) return PAWN;
-  if(lut.get_knight_attacks(sq) & opponent_knights) return KNIGHT;
-  if(lut.get_bishop_attacks(sq, m_board->get_all_pieces()) & opponent_bishops) return BISHOP;
-  if(lut.get_rook_attacks(sq, m_board->get_all_pieces()) & opponent_rooks) return ROOK;
-  if(lut.get_queen_attacks(sq, m_board->get_all_pieces()) & opponent_queens) return QUEEN;
-  // if(get_king_attacks(sq) & opponent_kings) return KING; /* not sure what to do here */
-  return EMPTY;
-}
-
-int MoveGenerator::least_valued_attacker_sq(int sq, bool white_turn) const
-{
-  bitboard opponent_knights;
-  bitboard opponent_pawns;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  if(m_board->is_white_turn()) {
-    opponent_knights = m_board->get_piece_bitboard(BLACK | KNIGHT);
-    opponent_pawns = m_board->get_piece_bitboard(BLACK | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_knights = m_board->get_piece_bitboard(WHITE | KNIGHT);
-    opponent_pawns = m_board->get_piece_bitboard(WHITE | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  bitboard pawns = lut.get_pawn_attacks(sq, white_turn) & opponent_pawns;
-  if(pawns) return first_set_bit(pawns);
-
-  bitboard knights = lut.get_knight_attacks(sq) & opponent_knights;
-  if(knights) return first_set_bit(knights);
-
-  bitboard bishops = lut.get_bishop_attacks(sq, m_board->get_all_pieces()) & opponent_bishops;
-  if(bishops) return first_set_bit(bishops);
-
-  bitboard rooks = lut.get_rook_attacks(sq, m_board->get_all_pieces()) & opponent_rooks;
-  if(rooks) return first_set_bit(rooks);
-
-  bitboard queens = lut.get_queen_attacks(sq, m_board->get_all_pieces()) & opponent_queens;
-  if(queens) return first_set_bit(queens);
-  return constants::NONE;
+  /* a pawn attacks sq if a pawn of the other color standing on sq would attack it */
+  return (lut.get_pawn_attacks(sq, false) & m_board->get_piece_bitboard(WHITE | PAWN)) |
+         (lut.get_pawn_attacks(sq, true) & m_board->get_piece_bitboard(BLACK | PAWN)) |
+         (lut.get_knight_attacks(sq) & (m_board->get_piece_bitboard(WHITE | KNIGHT) | m_board->get_piece_bitboard(BLACK | KNIGHT))) |
+         (lut.get_king_attacks(sq) & (m_board->get_piece_bitboard(WHITE | KING) | m_board->get_piece_bitboard(BLACK | KING))) |
+         (lut.get_bishop_attacks(sq, occupied) & (m_board->get_piece_bitboard(WHITE | BISHOP) | m_board->get_piece_bitboard(BLACK | BISHOP) | 
+                                                  m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN))) |
+         (lut.get_rook_attacks(sq, occupied) & (m_board->get_piece_bitboard(WHITE | ROOK) | m_board->get_piece_bitboard(BLACK | ROOK) | 
+                                                m_board->get_piece_bitboard(WHITE | QUEEN) | m_board->get_piece_bitboard(BLACK | QUEEN)));
 }
 
 bool MoveGenerator::is_attacked_by_pawn(int sq) const
@@ -1269,104 +1203,16 @@ bool MoveGenerator::is_attacked_by_pawn(int sq) const
   return false;
 }
 
+template <piece Us>
 bool MoveGenerator::is_attacked(int sq, bitboard blockers) const
 {
-  bitboard opponent_knights;
-  bitboard opponent_kings;
-  bitboard opponent_pawns;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  if(m_board->is_white_turn()) {
-    opponent_knights = m_board->get_piece_bitboard(BLACK | KNIGHT);
-    opponent_kings = m_board->get_piece_bitboard(BLACK | KING);
-    opponent_pawns = m_board->get_piece_bitboard(BLACK | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_knights = m_board->get_piece_bitboard(WHITE | KNIGHT);
-    opponent_kings = m_board->get_piece_bitboard(WHITE | KING);
-    opponent_pawns = m_board->get_piece_bitboard(WHITE | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  if(lut.get_bishop_attacks(sq, blockers) & opponent_bishops) return true;
-  if(lut.get_rook_attacks(sq, blockers) & opponent_rooks) return true;
-  if(lut.get_knight_attacks(sq) & opponent_knights) return true;
-  if(lut.get_pawn_attacks(sq, m_board->is_white_turn()) & opponent_pawns) return true;
-  if(lut.get_queen_attacks(sq, blockers) & opponent_queens) return true;
-  if(lut.get_king_attacks(sq) & opponent_kings) return true;
+  constexpr piece Them = Us ^ 1;
+  bitboard opponent_queens = m_board->get_piece_bitboard(Them | QUEEN);
+  if(lut.get_bishop_attacks(sq, blockers) & (m_board->get_piece_bitboard(Them | BISHOP) | opponent_queens)) return true;
+  if(lut.get_rook_attacks(sq, blockers) & (m_board->get_piece_bitboard(Them | ROOK) | opponent_queens)) return true;
+  if(lut.get_knight_attacks(sq) & m_board->get_piece_bitboard(Them | KNIGHT)) return true;
+  if(lut.get_pawn_attacks(sq, Us == WHITE) & m_board->get_piece_bitboard(Them | PAWN)) return true;
+  if(lut.get_king_attacks(sq) & m_board->get_piece_bitboard(Them | KING)) return true;
   return false;
 }
 
-bitboard MoveGenerator::attackers_from_square(int sq) const
-{
-  bitboard attackers = 0;
-  bitboard opponent_knights;
-  bitboard opponent_kings;
-  bitboard opponent_pawns;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  if(m_board->is_white_turn()) {
-    opponent_knights = m_board->get_piece_bitboard(BLACK | KNIGHT);
-    opponent_kings = m_board->get_piece_bitboard(BLACK | KING);
-    opponent_pawns = m_board->get_piece_bitboard(BLACK | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_knights = m_board->get_piece_bitboard(WHITE | KNIGHT);
-    opponent_kings = m_board->get_piece_bitboard(WHITE | KING);
-    opponent_pawns = m_board->get_piece_bitboard(WHITE | PAWN);
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  attackers |= lut.get_knight_attacks(sq) & opponent_knights;
-  attackers |= lut.get_king_attacks(sq) & opponent_kings;
-  attackers |= lut.get_pawn_attacks(sq, m_board->is_white_turn()) & opponent_pawns;
-  attackers |= lut.get_rook_attacks(sq, m_board->get_all_pieces()) & opponent_rooks;
-  attackers |= lut.get_bishop_attacks(sq, m_board->get_all_pieces()) & opponent_bishops;
-  attackers |= lut.get_queen_attacks(sq, m_board->get_all_pieces()) & opponent_queens;
-  return attackers;
-}
-
-bitboard MoveGenerator::opponent_slider_rays_to_square(int sq) const
-{
-  bitboard res = 0;
-  int attacker_loc;
-  bitboard attackers;
-  bitboard opponent_rooks;
-  bitboard opponent_bishops;
-  bitboard opponent_queens;
-  if(m_board->is_white_turn()) {
-    opponent_rooks = m_board->get_piece_bitboard(BLACK | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(BLACK | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(BLACK | QUEEN);
-  }
-  else {
-    opponent_rooks = m_board->get_piece_bitboard(WHITE | ROOK);
-    opponent_bishops = m_board->get_piece_bitboard(WHITE | BISHOP);
-    opponent_queens = m_board->get_piece_bitboard(WHITE | QUEEN);
-  }
-  bitboard rook_attacks_from_sq = lut.get_rook_attacks(sq, m_board->get_all_pieces());
-  attackers = rook_attacks_from_sq & (opponent_rooks | opponent_queens);
-  while(attackers) {
-    attacker_loc = first_set_bit(attackers);
-    res |= lut.get_rook_attacks(attacker_loc, m_board->get_all_pieces()) & rook_attacks_from_sq;
-    REMOVE_FIRST(attackers);    
-  }
-  bitboard bishop_attacks_from_sq = lut.get_bishop_attacks(sq, m_board->get_all_pieces());
-  attackers = bishop_attacks_from_sq & (opponent_bishops | opponent_queens);
-  while(attackers) {
-    attacker_loc = first_set_bit(attackers);
-    res |= lut.get_bishop_attacks(attacker_loc, m_board->get_all_pieces()) & bishop_attacks_from_sq;
-    REMOVE_FIRST(attackers);
-  }
-  return res;
-}
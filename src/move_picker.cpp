@@ -0,0 +1,134 @@
+#include "include/move_picker.h"
+#include "include/move.h"
+#include "include/move_gen.h"
+
+#include <utility>
+
+MovePicker::MovePicker(const MoveGenerator& move_gen, Move tt_move, int ply_from_root) :
+  m_move_gen{move_gen},
+  m_tt_move{tt_move},
+  m_ply_from_root{ply_from_root},
+  m_stage{Stage::TT_MOVE},
+  m_index{0}
+{
+  /* a stale or colliding tt entry can hand us a move that isn't legal here */
+  if (m_tt_move.is_no_move() || !m_move_gen.is_legal(m_tt_move))
+  {
+    m_tt_move = Move::NO_MOVE;
+    m_stage = Stage::GENERATE_CAPTURES;
+  }
+}
+
+MovePicker::MovePicker(const MoveGenerator& move_gen) :
+  m_move_gen{move_gen},
+  m_tt_move{Move::NO_MOVE},
+  m_ply_from_root{0},
+  m_stage{Stage::QSEARCH_GENERATE_CAPTURES},
+  m_index{0}
+{}
+
+Move MovePicker::next_move()
+{
+  Move move;
+  switch (m_stage)
+  {
+    case Stage::TT_MOVE:
+      m_stage = Stage::GENERATE_CAPTURES;
+      return m_tt_move;
+
+    case Stage::GENERATE_CAPTURES:
+      m_move_gen.generate_moves(m_moves, MoveGenerator::GenType::CAPTURES);
+      m_move_gen.score_moves(m_moves);
+      m_index = 0;
+      m_stage = Stage::GOOD_CAPTURES;
+      [[fallthrough]];
+
+    case Stage::GOOD_CAPTURES:
+      while (m_index < m_moves.size())
+      {
+        move = select_best();
+        if (move == m_tt_move) continue;
+        if (!m_move_gen.see_ge(move, 0))
+        {
+          m_bad_captures.push_back(move); /* try these after the quiets */
+          continue;
+        }
+        return move;
+      }
+      m_index = 0;
+      m_stage = Stage::KILLERS;
+      [[fallthrough]];
+
+    case Stage::KILLERS:
+      /* killers come from other positions at this ply, so check them before trusting them */
+      while (m_index < constants::NUM_KILLERS)
+      {
+        move = m_move_gen.get_killer(m_ply_from_root, m_index++);
+        if (move.is_no_move() || move == m_tt_move || move.is_capture() || !m_move_gen.is_legal(move)) continue;
+        return move;
+      }
+      m_stage = Stage::GENERATE_QUIETS;
+      [[fallthrough]];
+
+    case Stage::GENERATE_QUIETS:
+      m_moves.clear();
+      m_move_gen.generate_moves(m_moves, MoveGenerator::GenType::QUIETS);
+      m_move_gen.score_moves(m_moves, m_ply_from_root);
+      m_index = 0;
+      m_stage = Stage::QUIETS;
+      [[fallthrough]];
+
+    case Stage::QUIETS:
+      while (m_index < m_moves.size())
+      {
+        move = select_best();
+        if (move == m_tt_move || m_move_gen.is_killer(m_ply_from_root, move)) continue; // already tried
+        return move;
+      }
+      m_index = 0;
+      m_stage = Stage::BAD_CAPTURES;
+      [[fallthrough]];
+
+    case Stage::BAD_CAPTURES:
+      /* these were already handed out in score order */
+      if (m_index < m_bad_captures.size())
+      {
+        return m_bad_captures[m_index++];
+      }
+      m_stage = Stage::DONE;
+      return Move::NO_MOVE;
+
+    case Stage::QSEARCH_GENERATE_CAPTURES:
+      m_move_gen.generate_moves(m_moves, MoveGenerator::GenType::CAPTURES);
+      m_move_gen.score_moves(m_moves);
+      m_index = 0;
+      m_stage = Stage::QSEARCH_CAPTURES;
+      [[fallthrough]];
+
+    case Stage::QSEARCH_CAPTURES:
+      if (m_index < m_moves.size())
+      {
+        return select_best();
+      }
+      m_stage = Stage::DONE;
+      [[fallthrough]];
+
+    case Stage::DONE:
+      break;
+  }
+  return Move::NO_MOVE;
+}
+
+Move MovePicker::select_best()
+{
+  size_t best = m_index;
+  for (size_t i = m_index + 1; i < m_moves.size(); i++)
+  {
+    if (m_moves[i].score() > m_moves[best].score())
+    {
+      best = i;
+    }
+  }
+  std::swap(m_moves[m_index], m_moves[best]);
+  return m_moves[m_index++];
+}
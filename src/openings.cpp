@@ -4,128 +4,229 @@
 #include "include/move.h"
 #include "include/utils.h"
 #include "include/constants.h"
+#include "include/move_gen.h"
 
-#include <unordered_map>
 #include <vector>
 #include <iostream>
-#include <stdio.h>
 #include <fstream>
 #include <string>
-#include <sstream>
-#include <iterator>
-#include <stack>
+#include <algorithm>
 #include <random>
 
-OpeningBook::OpeningBook()
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+OpeningBook::OpeningBook(const std::string& path) :
+  m_mapping{nullptr},
+  m_mapping_size{0},
+  m_size{0},
+  m_format{Format::NATIVE},
+  m_best_move_only{false},
+  m_rng{std::random_device{}()}
 {
-  m_opening_book.clear();
-  srand(clock());
-  std::ifstream openings_file("assets/opening_book.pgn");
-  std::string line;
-  std::vector<std::string> split_line;
-  std::vector<Move> moves;
-  while(getline(openings_file, line)) {
-    split_line = utils::split(line, ' ');
-    uint64_t h = stoull(split_line[0]);
-    // std::cout << h << endl;
-    moves.clear();
-    for(int i = 1; i < split_line.size(); i++) {
-      moves.emplace_back(stoi(split_line[i]));
+  open(path);
+}
+
+OpeningBook::~OpeningBook()
+{
+  close();
+}
+
+bool OpeningBook::open(const std::string& path)
+{
+  close();
+  bool polyglot = path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false; /* no book, we'll just search from move one */
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Entry)))
+  {
+    /* shared and read only, so every engine process using this book shares the same pages */
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping != MAP_FAILED)
+    {
+      madvise(mapping, st.st_size, MADV_RANDOM); // binary search jumps around, don't read ahead
+      m_mapping = mapping;
+      m_mapping_size = st.st_size;
+      m_size = st.st_size / sizeof(Entry);
+      m_format = polyglot ? Format::POLYGLOT : Format::NATIVE;
     }
-    m_opening_book.insert(std::pair<uint64_t, std::vector<Move>>{h, moves});
   }
+  ::close(fd); // the mapping stays valid after the descriptor is closed
+  return is_loaded();
+}
+
+void OpeningBook::close()
+{
+  if (m_mapping)
+  {
+    munmap(m_mapping, m_mapping_size);
+  }
+  m_mapping = nullptr;
+  m_mapping_size = 0;
+  m_size = 0;
 }
 
 Move OpeningBook::get_opening_move(Board::Ptr board)
 {
+  if (!is_loaded())
+  {
+    return Move::NO_MOVE;
+  }
+  return (m_format == Format::POLYGLOT) ? get_polyglot_move(board) : get_native_move(board);
+}
+
+size_t OpeningBook::pick(const std::vector<uint16_t>& weights)
+{
+  uint64_t total_weight = 0;
+  size_t best = 0;
+  for (size_t i = 0; i < weights.size(); i++)
+  {
+    total_weight += weights[i];
+    best = (weights[i] > weights[best]) ? i : best;
+  }
+  if (m_best_move_only || total_weight == 0)
+  {
+    return best;
+  }
+
+  uint64_t r = std::uniform_int_distribution<uint64_t>{0, total_weight - 1}(m_rng);
+  for (size_t i = 0; i < weights.size(); i++)
+  {
+    if (r < weights[i])
+    {
+      return i;
+    }
+    r -= weights[i];
+  }
+  return best; // unreachable
+}
+
+Move OpeningBook::get_native_move(Board::Ptr board)
+{
+  const Entry* entries = static_cast<const Entry*>(m_mapping);
   uint64_t h = board->get_hash();
-  std::cout << h << std::endl;
-  std::unordered_map<uint64_t, std::vector<Move>>::iterator got_board = m_opening_book.find(h);
-  if(got_board == m_opening_book.end()) 
+  auto range = std::equal_range(entries, entries + m_size, Entry{h, 0, 0, 0},
+                                [](const Entry& a, const Entry& b) { return a.key < b.key; });
+  if (range.first == range.second)
   {
-    std::cout << "here!" << std::endl;
     return Move::NO_MOVE; // position not found
   }
-  unsigned int r = utils::rand64() % got_board->second.size();
 
-  if(got_board->second.size() == 0) 
+  std::vector<uint16_t> weights;
+  for (const Entry* e = range.first; e != range.second; e++)
   {
-    std::cerr << "No known moves from this position!" << std::endl;
+    weights.push_back(e->weight);
   }
-  return got_board->second[r];
+  return Move{range.first[pick(weights)].move};
 }
 
+Move OpeningBook::get_polyglot_move(Board::Ptr board)
+{
+  const PolyglotEntry* entries = static_cast<const PolyglotEntry*>(m_mapping);
+  uint64_t key = board->get_polyglot_key();
+  auto range = std::equal_range(entries, entries + m_size, PolyglotEntry{__builtin_bswap64(key), 0, 0, 0},
+                                [](const PolyglotEntry& a, const PolyglotEntry& b) {
+                                  return __builtin_bswap64(a.key) < __builtin_bswap64(b.key);
+                                });
+  if (range.first == range.second)
+  {
+    return Move::NO_MOVE; // position not found
+  }
+
+  std::vector<uint16_t> weights;
+  for (const PolyglotEntry* e = range.first; e != range.second; e++)
+  {
+    weights.push_back(__builtin_bswap16(e->weight));
+  }
+  uint16_t poly_move = __builtin_bswap16(range.first[pick(weights)].move);
+
+  int to = ((poly_move >> 3) & 7) * 8 + (poly_move & 7);
+  int from = ((poly_move >> 9) & 7) * 8 + ((poly_move >> 6) & 7);
+  int promo = (poly_move >> 12) & 7; // 0: none, 1: knight, 2: bishop, 3: rook, 4: queen
+
+  /* polyglot writes castling as the king capturing its own rook */
+  if (PIECE((*board)[from]) == KING)
+  {
+    if      (from == constants::E1 && to == constants::H1) to = constants::G1;
+    else if (from == constants::E1 && to == constants::A1) to = constants::C1;
+    else if (from == constants::E8 && to == constants::H8) to = constants::G8;
+    else if (from == constants::E8 && to == constants::A8) to = constants::C8;
+  }
+
+  /* book moves don't carry our move flags, so match them against the legal moves */
+  MoveGenerator move_gen{board};
+  MoveList moves;
+  move_gen.generate_moves(moves);
+  for (Move move : moves)
+  {
+    if (move.from() == from && move.to() == to &&
+        (move.is_promo() ? (move.type() & 0x3) + 1 == promo : promo == 0))
+    {
+      return move;
+    }
+  }
+  return Move::NO_MOVE; // illegal book move, the key must have collided
+}
+
+size_t OpeningBook::compile(const std::string& text_path, const std::string& book_path)
+{
+  std::ifstream text_file(text_path);
+  if (!text_file)
+  {
+    std::cerr << "Could not open " << text_path << std::endl;
+    return 0;
+  }
+
+  std::vector<Entry> entries;
+  std::string line;
+  std::vector<std::string> split_line;
+  while (getline(text_file, line))
+  {
+    split_line = utils::split(line, ' ');
+    if (split_line.size() < 2)
+    {
+      continue;
+    }
+    uint64_t h = stoull(split_line[0]);
+    for (size_t i = 1; i < split_line.size(); i++)
+    {
+      if (split_line[i].empty()) continue;
+      uint16_t move = stoi(split_line[i]) & 0xFFFF;
+      entries.push_back(Entry{h, move, 1, 0});
+    }
+  }
 
-/// TODO: these functions below are kinda useless... ignoring for now
-// std::unordered_map<uint64_t, std::vector<Move>> OpeningBook::create_opening_book() const;
-
-
-// std::unordered_map<uint64_t, std::vector<move_t>> create_opening_book() {
-//   srand(clock());
-//   decode_fen(constants::STARTFEN);
-
-//   // board_t board;
-
-//   uint64_t h;
-
-//   std::unordered_map<uint64_t, std::vector<move_t>> opening_book_local;
-
-//   std::ifstream openings_file("assets/opening_book_lines.pgn");
-//   std::string line;
-//   move_t move;
-//   std::unordered_map<uint64_t, std::vector<move_t>>::iterator got_board;
-//   std::vector<std::string> split_line;
-//   std::string notation;
-//   while(getline(openings_file, line)) {
-//     split_line = split(line, ' ');
-//     for (int i = 0; i < split_line.size(); i++) {
-//       notation = split_line[i];
-//       if(notation == "") continue;
-//       h = zobrist_hash();
-//       move = move_from_notation(notation);
-//       got_board = opening_book_local.find(h);
-//       if(got_board == opening_book_local.end()) { // board is not in the map
-//         std::vector<move_t> empty;
-//         opening_book_local.insert(std::pair<uint64_t, std::vector<move_t>> (h, empty));
-//       }
-//       else { // board is in the map
-//         got_board->second.push_back(move);
-//       }
-//       if(i == (split_line.size() - 1)) { // don't need to make the final move
-//         break;
-//       }
-//       make_move(move);
-//     }
-//     decode_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
-//   }
-
-//   openings_file.close();
-//   return opening_book_local;
-// }
-
-// std::unordered_map<uint64_t, std::vector<move_t>> opening_book;
-
-// void generate_num_data() {
-//   std::ofstream outfile;
-//   outfile.open("assets/opening_book.pgn");
-//   std::vector<move_t> moves;
-//   std::unordered_map<uint64_t, std::vector<move_t>>::iterator it;
-//   for(it = opening_book.begin(); it != opening_book.end(); it++) {
-//     moves = it->second;
-//     if(moves.size() == 0) continue; // don't care about positions we don't know the theory for
-//     outfile << it->first << " ";
-
-//     moves = it->second;
-//     for (move_t move : moves) {
-//       outfile << move << " ";
-//     }
-//     outfile << "\n";
-//   }
-//   outfile.close();
-//   return;
-// }
-
-
-// move_t get_opening_move() {
-  
-// }
+  /* merge repeated moves from the same position into a single weighted entry */
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.key < b.key || (a.key == b.key && a.move < b.move);
+  });
+  std::vector<Entry> merged;
+  for (const Entry& e : entries)
+  {
+    if (!merged.empty() && merged.back().key == e.key && merged.back().move == e.move)
+    {
+      merged.back().weight = std::min<uint32_t>(merged.back().weight + e.weight, UINT16_MAX);
+    }
+    else
+    {
+      merged.push_back(e);
+    }
+  }
+
+  std::ofstream book_file(book_path, std::ios::binary);
+  if (!book_file)
+  {
+    std::cerr << "Could not open " << book_path << std::endl;
+    return 0;
+  }
+  book_file.write(reinterpret_cast<const char*>(merged.data()), merged.size() * sizeof(Entry));
+  return merged.size();
+}
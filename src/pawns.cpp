@@ -0,0 +1,180 @@
+#include "include/pawns.h"
+#include "include/board.h"
+#include "include/bitboard.h"
+#include "include/constants.h"
+#include "include/utils.h"
+
+#include <algorithm>
+
+PawnTable::PawnTable(size_t megabytes)
+{
+  resize(megabytes);
+
+  for (int file = 0; file < 8; file++)
+  {
+    m_file_masks[file] = (bitboard)0x0101010101010101 << file;
+  }
+  for (int file = 0; file < 8; file++)
+  {
+    m_adjacent_files[file] = ((file > 0) ? m_file_masks[file - 1] : 0) | ((file < 7) ? m_file_masks[file + 1] : 0);
+  }
+
+  for (int sq = 0; sq < 64; sq++)
+  {
+    int file = utils::file(sq);
+    int rank = utils::rank(sq);
+    for (int color = WHITE; color <= BLACK; color++)
+    {
+      bool white = (color == WHITE);
+      bitboard front_span = 0;
+      bitboard support = 0;
+      for (int r = 0; r < 8; r++)
+      {
+        bool ahead = white ? (r > rank) : (r < rank);
+        bitboard rank_mask = (bitboard)0xFF << (8 * r);
+        front_span |= ahead ? (rank_mask & m_file_masks[file]) : 0;
+        support |= !ahead ? (rank_mask & m_adjacent_files[file]) : 0;
+      }
+      m_front_spans[color][sq] = front_span;
+      m_support_masks[color][sq] = support;
+      /* the shifts wrap around the board edge, so cut the result back down to the three files */
+      m_passed_masks[color][sq] = (front_span | (front_span << 1) | (front_span >> 1)) & (m_file_masks[file] | m_adjacent_files[file]);
+
+      bitboard attacks = 0;
+      int forward = white ? rank + 1 : rank - 1;
+      if (forward >= 0 && forward < 8)
+      {
+        if (file > 0) attacks |= BIT_FROM_SQ((forward * 8 + file - 1));
+        if (file < 7) attacks |= BIT_FROM_SQ((forward * 8 + file + 1));
+      }
+      m_pawn_attacks[color][sq] = attacks;
+    }
+  }
+}
+
+void PawnTable::resize(size_t megabytes)
+{
+  size_t entries = std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Entry), 1);
+  /* power of two so the pawn hash can be masked into an index */
+  size_t size = 1;
+  while (size * 2 <= entries)
+  {
+    size *= 2;
+  }
+  m_table = static_cast<Entry*>(m_memory.allocate(size * sizeof(Entry)));
+  m_mask = size - 1;
+  clear();
+}
+
+void PawnTable::clear()
+{
+  for (size_t i = 0; i <= m_mask; i++)
+  {
+    m_table[i] = Entry{0, 0, {0, 0}, {constants::NONE, constants::NONE}};
+  }
+}
+
+PawnTable::Entry* PawnTable::probe(const Board& board)
+{
+  uint64_t key = board.get_pawn_hash();
+  Entry* entry = &m_table[key & m_mask];
+  if (entry->key == key)
+  {
+    return entry;
+  }
+
+  entry->key = key;
+  entry->score = evaluate(board);
+  entry->king_sq[0] = entry->king_sq[1] = constants::NONE;
+  return entry;
+}
+
+Score PawnTable::get_king_shield(Entry* entry, const Board& board, bool white)
+{
+  int color = white ? WHITE : BLACK;
+  int king_sq = white ? board.get_white_king_loc() : board.get_black_king_loc();
+  if (entry->king_sq[color] != king_sq)
+  {
+    bitboard own_pawns = board.get_piece_bitboard(white ? (WHITE | PAWN) : (BLACK | PAWN));
+    entry->shield[color] = evaluate_shield(own_pawns, king_sq, white);
+    entry->king_sq[color] = king_sq;
+  }
+  return white ? entry->shield[color] : -entry->shield[color];
+}
+
+Score PawnTable::evaluate(const Board& board)
+{
+  bitboard white_pawns = board.get_piece_bitboard(WHITE | PAWN);
+  bitboard black_pawns = board.get_piece_bitboard(BLACK | PAWN);
+  return evaluate_side(white_pawns, black_pawns, true) - evaluate_side(black_pawns, white_pawns, false);
+}
+
+Score PawnTable::evaluate_side(bitboard own_pawns, bitboard their_pawns, bool white)
+{
+  int color = white ? WHITE : BLACK;
+  Score score = 0;
+  bitboard pawns = own_pawns;
+  while (pawns)
+  {
+    int sq = first_set_bit(pawns);
+    REMOVE_FIRST(pawns);
+    int file = utils::file(sq);
+    int relative_rank = white ? utils::rank(sq) : 7 - utils::rank(sq);
+
+    bool doubled = own_pawns & m_front_spans[color][sq];
+    bool isolated = !(own_pawns & m_adjacent_files[file]);
+
+    if (doubled)
+    {
+      score += constants::DOUBLED_PAWN; // only the pawns behind are counted, so a pair costs once
+    }
+
+    if (isolated)
+    {
+      score += constants::ISOLATED_PAWN;
+    }
+    else if (!(own_pawns & m_support_masks[color][sq]))
+    {
+      /* nothing can come up to defend it, and an enemy pawn already controls the square in front */
+      int stop_sq = white ? sq + 8 : sq - 8;
+      if (their_pawns & m_pawn_attacks[color][stop_sq])
+      {
+        score += constants::BACKWARD_PAWN;
+      }
+    }
+
+    if (!doubled && !(their_pawns & m_passed_masks[color][sq]))
+    {
+      score += constants::passed_pawn_bonus[relative_rank];
+    }
+  }
+  return score;
+}
+
+Score PawnTable::evaluate_shield(bitboard own_pawns, int king_sq, bool white)
+{
+  int forward = white ? 8 : -8;
+  int king_rank = utils::rank(king_sq);
+  /* keep the three files on the board when the king is on the edge */
+  int center_file = std::clamp(utils::file(king_sq), 1, 6);
+
+  int shield = 0;
+  for (int file = center_file - 1; file <= center_file + 1; file++)
+  {
+    int close_sq = king_rank * 8 + file + forward;
+    int far_sq = close_sq + forward;
+    if (close_sq >= 0 && close_sq < 64 && (own_pawns & BIT_FROM_SQ(close_sq)))
+    {
+      shield += constants::SHIELD_PAWN_CLOSE;
+    }
+    else if (far_sq >= 0 && far_sq < 64 && (own_pawns & BIT_FROM_SQ(far_sq)))
+    {
+      shield += constants::SHIELD_PAWN_FAR;
+    }
+    else
+    {
+      shield += constants::SHIELD_PAWN_MISSING;
+    }
+  }
+  return make_score(shield, 0); // the shield stops mattering once the queens are off
+}
@@ -0,0 +1,31 @@
+#include "include/perft.h"
+
+#include <algorithm>
+
+PerftTable::PerftTable(size_t megabytes)
+{
+  resize(megabytes);
+}
+
+void PerftTable::resize(size_t megabytes)
+{
+  size_t entries = std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Entry), 1);
+  /* power of two so the hash can be masked into an index */
+  size_t size = 1;
+  while (size * 2 <= entries)
+  {
+    size *= 2;
+  }
+  m_table = static_cast<Entry*>(m_memory.allocate(size * sizeof(Entry)));
+  m_mask = size - 1;
+  clear();
+}
+
+void PerftTable::clear()
+{
+  for (size_t i = 0; i <= m_mask; i++)
+  {
+    m_table[i].key.store(0, std::memory_order_relaxed);
+    m_table[i].data.store(0, std::memory_order_relaxed);
+  }
+}
@@ -2,12 +2,14 @@
 #include "include/bitboard.h"
 #include "include/board.h"
 #include "include/move.h"
+#include "include/move_picker.h"
 #include "include/attacks.h"
 #include "include/tt.h"
 #include "include/openings.h"
 #include "include/evaluation.h"
 #include "include/constants.h"
 #include "include/utils.h"
+#include "include/perft.h"
 
 #include <vector>
 #include <unordered_set>
@@ -16,32 +18,126 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <array>
+#include <cmath>
+
+/* late move reductions by depth and move number, the later and deeper the move the less we trust it */
+static const auto lmr_reductions = []() {
+  std::array<std::array<int, 64>, 64> table{};
+  for (int depth = 1; depth < 64; depth++)
+  {
+    for (int move_number = 1; move_number < 64; move_number++)
+    {
+      table[depth][move_number] = static_cast<int>(0.75 + std::log(depth) * std::log(move_number) / 2.25);
+    }
+  }
+  return table;
+}();
+
+Searcher::Searcher(Board::Ptr board) : 
+  m_board{board}, 
+  m_move_gen{board}, 
+  m_tt{constants::HASH_MB}, 
+  m_eval_cache_mb{constants::EVAL_CACHE_MB}, 
+  m_pawn_hash_mb{constants::PAWN_HASH_MB}, 
+  m_max_depth{INT_MAX}, 
+  m_searching{false}, 
+  m_quit{false}, 
+  m_abort_search{false}
+{
+  set_threads(1);
+  m_search_thread = std::thread{&Searcher::search_thread_loop, this};
+}
+
+/* bulk counts the last ply, and looks every subtree deeper than that up in the table first */
+static uint64_t perft_nodes(Board& board, const MoveGenerator& move_gen, PerftTable& table, int depth)
+{
+  if (depth >= 2)
+  {
+    std::optional<uint64_t> nodes = table.probe(board.get_hash(), depth);
+    if (nodes)
+    {
+      return *nodes;
+    }
+  }
+
+  MoveList moves;
+  move_gen.generate_moves(moves);
+  if (depth == 1)
+  {
+    return moves.size();
+  }
 
-Searcher::Searcher(Board::Ptr board) : m_board{board}, m_move_gen{board}, m_tt{constants::SEARCH_TT_SIZE}, m_evaluator{m_board} {}
+  uint64_t nodes = 0;
+  for (Move move : moves)
+  {
+    board.make_move(move);
+    nodes += perft_nodes(board, move_gen, table, depth - 1);
+    board.unmake_move(move);
+  }
+  table.store(board.get_hash(), depth, nodes);
+  return nodes;
+}
 
-uint64_t Searcher::perft(int depth)
+uint64_t Searcher::perft(int depth, size_t threads)
 {
-  std::vector<Move> moves;
+  halt(); // the search thread reads the same board
+  auto start = std::chrono::steady_clock::now();
+  depth = std::max(depth, 1);
+  threads = std::max<size_t>(threads, 1);
+
+  MoveList moves;
   m_move_gen.generate_moves(moves);
+  m_move_gen.sort_by_long_algebraic_notation(moves);
+
+  PerftTable table{constants::PERFT_HASH_MB};
+  std::vector<uint64_t> nodes_from_move(moves.size());
+  std::atomic<size_t> next_move{0};
+
+  /* root moves are handed out one at a time, so a thread that drew a small subtree just takes another */
+  auto count_root_moves = [&]()
+  {
+    Board::Ptr board = std::make_shared<Board>(*m_board);
+    board->set_prefetch_tables(nullptr, nullptr, nullptr);
+    MoveGenerator move_gen{board};
+    for (size_t i = next_move++; i < moves.size(); i = next_move++)
+    {
+      board->make_move(moves[i]);
+      nodes_from_move[i] = (depth > 1) ? perft_nodes(*board, move_gen, table, depth - 1) : 1;
+      board->unmake_move(moves[i]);
+    }
+  };
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < threads; i++)
+  {
+    helpers.emplace_back(count_root_moves);
+  }
+  count_root_moves();
+  for (std::thread& helper : helpers)
+  {
+    helper.join();
+  }
 
   uint64_t total_nodes = 0;
-  uint64_t nodes_from_move;
-  m_move_gen.sort_by_long_algebraic_notation(moves);
-  for (Move& move : moves) {
-    std::cout << m_move_gen.move_to_long_algebraic(move) << ": ";
-    m_board->make_move(move);
-    nodes_from_move = num_nodes_bulk(depth - 1);
-    total_nodes += nodes_from_move;
-    std::cout << nodes_from_move << std::endl;
-    m_board->unmake_move(move);
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    std::cout << m_move_gen.move_to_long_algebraic(moves[i]) << ": " << nodes_from_move[i] << std::endl;
+    total_nodes += nodes_from_move[i];
   }
-  std::cout << std::endl << "Nodes searched: " << total_nodes << std::endl << std::endl;
+  uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  std::cout << std::endl << "Nodes searched: " << total_nodes << std::endl;
+  std::cout << "Time: " << ms << " ms" << std::endl;
+  std::cout << "NPS: " << total_nodes * 1000 / std::max<uint64_t>(ms, 1) << std::endl << std::endl;
   return total_nodes;
 }
 
 uint64_t Searcher::num_nodes_bulk(int depth)
 {
-  std::vector<Move> moves;
+  MoveList moves;
   m_move_gen.generate_moves(moves);
   if (depth == 1) {
     return moves.size();
@@ -66,7 +162,7 @@ uint64_t Searcher::num_nodes(int depth)
   }
 
   uint64_t total_moves = 0;
-  std::vector<Move> moves;
+  MoveList moves;
   m_move_gen.generate_moves(moves);
   for (Move& move : moves) {
     m_board->make_move(move);
@@ -76,68 +172,427 @@ uint64_t Searcher::num_nodes(int depth)
   return total_moves;
 }
 
-void Searcher::find_best_move()
+Searcher::~Searcher()
+{
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_quit = true;
+  }
+  m_abort_search = true;
+  m_search_cv.notify_all();
+  m_search_thread.join();
+}
+
+void Searcher::find_best_move(const TimeManager::Limits& limits)
+{
+  halt();
+  m_time_manager.start(limits);
+  prepare_search();
+  run_search(limits.depth);
+}
+
+void Searcher::start_search(const TimeManager::Limits& limits)
+{
+  halt(); // normally instant, the gui only sends go once the last search sent bestmove
+
+  /* play straight from the book when we are on a clock, infinite searches have to wait for stop */
+  if (limits.time_left > 0 || limits.move_time > 0)
+  {
+    Move book_move = m_opening_book.get_opening_move(m_board);
+    if (!book_move.is_no_move() && m_move_gen.is_legal(book_move))
+    {
+      m_best_move = book_move;
+      std::cout << ("bestmove " + m_move_gen.move_to_long_algebraic(book_move) + "\n") << std::flush;
+      return;
+    }
+  }
+
+  m_time_manager.start(limits);
+  prepare_search();
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_max_depth = limits.depth;
+    m_searching = true;
+  }
+  m_search_cv.notify_all();
+}
+
+void Searcher::stop()
+{
+  /* the search thread sends bestmove once it notices */
+  abort_search();
+}
+
+void Searcher::halt()
+{
+  /* waiting alone would block the uci thread for good behind go infinite */
+  stop();
+  wait();
+}
+
+void Searcher::wait()
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_search_cv.wait(lock, [this] { return !m_searching; });
+}
+
+void Searcher::prepare_search()
+{
+  m_abort_search = false;
+  m_tt.new_search();
+  for (auto& worker : m_workers)
+  {
+    worker->set_position(*m_board);
+  }
+}
+
+void Searcher::run_search(int max_depth)
+{
+  /* the helpers search the same position and only talk to the main thread through the tt */
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < m_workers.size(); i++)
+  {
+    helpers.emplace_back(&SearchWorker::iterative_deepening, m_workers[i].get(), max_depth);
+  }
+
+  m_workers[0]->iterative_deepening(max_depth);
+
+  /* once the main thread is done, the helpers have nothing left to contribute */
+  m_abort_search = true;
+  for (auto& helper : helpers)
+  {
+    helper.join();
+  }
+
+  /* prefer the deepest completed iteration, falling back on the main thread for ties */
+  SearchWorker::Ptr best_worker = m_workers[0];
+  for (auto& worker : m_workers)
+  {
+    if (!worker->get_best_move().is_no_move() && 
+        (best_worker->get_best_move().is_no_move() || worker->get_completed_depth() > best_worker->get_completed_depth()))
+    {
+      best_worker = worker;
+    }
+  }
+  m_best_move = best_worker->get_best_move();
+  m_best_score = best_worker->get_best_score();
+}
+
+void Searcher::search_thread_loop()
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  for ( ;; )
+  {
+    m_search_cv.wait(lock, [this] { return m_searching || m_quit; });
+    if (m_quit)
+    {
+      return;
+    }
+
+    /* don't hold the lock while searching so stop, isready and friends never wait on us */
+    int max_depth = m_max_depth;
+    lock.unlock();
+    run_search(max_depth);
+    Move best_move = get_best_move();
+    /* m_board belongs to the uci thread, the main worker's copy is ours and is back at the root */
+    std::string best_move_str = best_move.is_no_move() ? "0000" : m_workers[0]->get_move_gen().move_to_long_algebraic(best_move);
+    std::cout << ("bestmove " + best_move_str + "\n") << std::flush; // one write so it can't interleave with the uci thread
+    lock.lock();
+
+    m_searching = false;
+    m_search_cv.notify_all();
+  }
+}
+
+void Searcher::abort_search()
+{
+  m_abort_search = true;
+}
+
+Move Searcher::get_best_move()
+{
+  return m_best_move;
+}
+
+void Searcher::set_threads(size_t threads)
+{
+  halt(); // the workers can't change under a running search
+  threads = std::clamp<size_t>(threads, 1, constants::MAX_THREADS);
+  m_workers.resize(std::min(m_workers.size(), threads));
+  while (m_workers.size() < threads)
+  {
+    m_workers.push_back(std::make_shared<SearchWorker>(m_workers.size(), m_tt, m_time_manager, m_abort_search, 
+                                                       m_workers, m_eval_cache_mb, m_pawn_hash_mb));
+  }
+}
+
+size_t Searcher::get_threads() const
+{
+  return m_workers.size();
+}
+
+void Searcher::clear_tt()
+{
+  halt();
+  m_tt.clear(m_workers.size()); // the search threads are idle, so use as many threads to clear it
+  for (auto& worker : m_workers)
+  {
+    worker->get_evaluator().clear_eval_table();
+  }
+}
+
+void Searcher::set_hash_size(size_t megabytes)
 {
+  halt(); // the table can't move under a running search
+  m_tt.resize(std::clamp<size_t>(megabytes, 1, constants::MAX_HASH_MB));
+}
+
+bool Searcher::save_tt(const std::string& path)
+{
+  halt(); // the table has to hold still while it's written
+  return m_tt.save(path);
+}
+
+bool Searcher::load_tt(const std::string& path)
+{
+  halt();
+  return m_tt.load(path);
+}
+
+void Searcher::set_eval_table_sizes(size_t eval_cache_mb, size_t pawn_hash_mb)
+{
+  halt();
+  m_eval_cache_mb = std::clamp<size_t>(eval_cache_mb, 1, constants::MAX_EVAL_CACHE_MB);
+  m_pawn_hash_mb = std::clamp<size_t>(pawn_hash_mb, 1, constants::MAX_PAWN_HASH_MB);
+  for (auto& worker : m_workers)
+  {
+    worker->get_evaluator().resize_tables(m_eval_cache_mb, m_pawn_hash_mb);
+  }
+}
+
+bool Searcher::set_book(const std::string& path)
+{
+  halt(); // the book is read at the start of a search
+  return m_opening_book.open(path);
+}
+
+void Searcher::set_book_best_move(bool best_move_only)
+{
+  halt();
+  m_opening_book.set_best_move_only(best_move_only);
+}
+
+std::string Searcher::get_memory_info() const
+{
+  Evaluator& evaluator = m_workers[0]->get_evaluator(); // every thread allocates the same way
+  return "Hash " + std::to_string(m_tt.get_size_mb()) + " MB on " + LargePageBuffer::mode_name(m_tt.get_page_mode()) + 
+         ", EvalHash " + std::to_string(m_eval_cache_mb) + " MB on " + LargePageBuffer::mode_name(evaluator.get_eval_cache_page_mode()) + 
+         ", PawnHash " + std::to_string(m_pawn_hash_mb) + " MB on " + LargePageBuffer::mode_name(evaluator.get_pawn_table_page_mode());
+}
+
+uint64_t Searcher::get_nodes() const
+{
+  uint64_t nodes = 0;
+  for (auto& worker : m_workers)
+  {
+    nodes += worker->get_nodes();
+  }
+  return nodes;
+}
+
+///////////////////////////////////////////////// SEARCH WORKER /////////////////////////////////////////////////
+
+SearchWorker::SearchWorker(int id, TranspositionTable& tt, TimeManager& time_manager, std::atomic<bool>& abort_search, 
+                           const std::vector<Ptr>& workers, size_t eval_cache_mb, size_t pawn_hash_mb) : 
+  m_id{id}, 
+  m_board{std::make_shared<Board>()}, 
+  m_move_gen{m_board}, 
+  m_evaluator{m_board, eval_cache_mb, pawn_hash_mb}, 
+  m_tt{tt}, 
+  m_time_manager{time_manager}, 
+  m_abort_search{abort_search}, 
+  m_workers{workers}, 
+  m_nodes{0} 
+{
+  m_board->set_prefetch_tables(&m_tt, &m_evaluator.get_eval_cache(), &m_evaluator.get_pawn_table());
+}
+
+void SearchWorker::set_position(const Board& board)
+{
+  *m_board = board;
+  m_board->set_prefetch_tables(&m_tt, &m_evaluator.get_eval_cache(), &m_evaluator.get_pawn_table()); // the copy brought the other board's
   m_move_gen.clear_killers(); // clear the killer moves
+  m_move_gen.age_history(); // keep what the last search learned, but let this one take over quickly
   m_best_move = Move::NO_MOVE;
+  m_best_score = 0;
+  m_completed_depth = 0;
+  m_nodes = 0;
+  m_root_pv.clear();
+  m_next_time_check = constants::TIME_CHECK_NODES;
+}
 
-  for (size_t depth = 1; depth < INT_MAX; depth++) 
+void SearchWorker::iterative_deepening(int max_depth)
+{
+  /* odd helpers skip the first iteration so that the threads don't all search the same depth in lockstep */
+  int start_depth = 1 + (m_id & 1);
+  for (int depth = start_depth; depth <= max_depth; depth++) 
   {
-    m_best_move_this_iteration = Move::NO_MOVE;
-    m_best_score_this_iteration = INT_MIN + 1;
-    search(0, depth, INT_MIN + 1, INT_MAX, true, true);
+    int64_t iteration_start = m_time_manager.elapsed();
+    Move prev_best_move = m_best_move;
+    m_seldepth = 0;
 
-    if (!m_best_move_this_iteration.is_no_move())
+    /*
+      Aspiration Windows:
+        - The score rarely moves much from one iteration to the next, so the root is searched with a
+        narrow window around the last score, which cuts off far more of the tree than a full window.
+        - If the score falls outside the window the root is searched again with the window widened on
+        that side, until it lands inside or the window is as wide as it can get.
+    */
+    int window = constants::ASPIRATION_WINDOW;
+    int64_t alpha = INT_MIN + 1;
+    int64_t beta = INT_MAX;
+    if (depth >= constants::ASPIRATION_MIN_DEPTH && !utils::is_mate_score(m_best_score))
     {
+      alpha = std::max<int64_t>(m_best_score - window, INT_MIN + 1);
+      beta = std::min<int64_t>(m_best_score + window, INT_MAX);
+    }
 
-      m_best_move = m_best_move_this_iteration;
-      m_best_score = m_best_score_this_iteration;
-      // std::cout << "info depth " << depth << " currmove " << m_move_gen.move_to_long_algebraic(m_best_move) 
-      //           << " cp " << m_best_score * (m_board->is_white_turn() ? 1 : -1) << std::endl;
+    for ( ;; )
+    {
+      m_best_move_this_iteration = Move::NO_MOVE;
+      m_best_score_this_iteration = INT_MIN + 1;
+      int score = search(0, depth, alpha, beta, true, true);
+      if (m_abort_search)
+      {
+        break;
+      }
+
+      /* a fail high still found a better move than before, a fail low found nothing */
+      if (!m_best_move_this_iteration.is_no_move())
+      {
+        m_best_move = m_best_move_this_iteration;
+        m_best_score = m_best_score_this_iteration;
+        m_root_pv.assign(m_pv[0], m_pv[0] + m_pv_length[0]);
+      }
+      report_iteration(depth, score, alpha, beta);
+
+      if (score <= alpha)
+      {
+        beta = (alpha + beta) / 2; // the score is probably going down, don't leave the window too high
+        alpha = std::max<int64_t>(score - window, INT_MIN + 1);
+      }
+      else if (score >= beta)
+      {
+        beta = std::min<int64_t>(score + window, INT_MAX);
+      }
+      else
+      {
+        break;
+      }
+
+      window *= 2;
+      if (window > constants::ASPIRATION_MAX_WINDOW)
+      {
+        alpha = INT_MIN + 1;
+        beta = INT_MAX;
+      }
     }
 
     if (m_abort_search)
     {
       break;
     }
-    
+    m_completed_depth = depth;
+
+    /* only the main thread decides when the search is over */
+    if (m_id == 0)
+    {
+      m_time_manager.iteration_finished(!prev_best_move.is_no_move() && !(prev_best_move == m_best_move));
+      if (m_time_manager.should_stop(m_time_manager.elapsed() - iteration_start))
+      {
+        break;
+      }
+    }
   }
-  m_abort_search = false; // reset
 }
 
-// spawns a thread to do the searching and returns 
-void Searcher::ponder()
+void SearchWorker::report_iteration(int depth, int score, int64_t alpha, int64_t beta) const
 {
-  if (m_search_thread.joinable())
+  if (m_id != 0)
+  {
+    return; // the helpers search quietly
+  }
+
+  std::string info = "info depth " + std::to_string(depth) + " seldepth " + std::to_string(m_seldepth) + " score ";
+  if (utils::is_mate_score(score))
+  {
+    int moves = utils::moves_until_mate(score) + 1;
+    info += "mate " + std::to_string((score > 0) ? moves : -moves);
+  }
+  else
+  {
+    info += "cp " + std::to_string(score);
+  }
+  /* outside the window the score is only a bound on the real one */
+  if (score <= alpha)
+  {
+    info += " upperbound";
+  }
+  else if (score >= beta)
   {
-    m_search_thread.join();
+    info += " lowerbound";
+  }
+
+  uint64_t nodes = 0;
+  for (const Ptr& worker : m_workers)
+  {
+    nodes += worker->get_nodes();
+  }
+  int64_t elapsed = m_time_manager.elapsed();
+  info += " nodes " + std::to_string(nodes) + 
+          " nps " + std::to_string(nodes * 1000 / std::max<int64_t>(elapsed, 1)) + 
+          " hashfull " + std::to_string(static_cast<int>(m_tt.get_occupancy() * 1000)) + 
+          " time " + std::to_string(elapsed);
+
+  if (!m_root_pv.empty())
+  {
+    info += " pv";
+    for (Move move : m_root_pv)
+    {
+      info += " " + m_move_gen.move_to_long_algebraic(move);
+    }
   }
-  // start searching
-  m_search_thread = std::thread{&Searcher::find_best_move, this};
+  std::cout << (info + "\n") << std::flush; // one write so it can't interleave with the uci thread
 }
 
-void Searcher::stop()
+void SearchWorker::check_time()
 {
-  // stop searching
-  abort_search();
-  if (m_search_thread.joinable())
+  if (m_id != 0 || m_nodes < m_next_time_check)
+  {
+    return;
+  }
+  m_next_time_check = m_nodes + constants::TIME_CHECK_NODES;
+  /* always finish the first iteration so there is a move to play */
+  if (m_completed_depth > 0 && m_time_manager.hard_limit_reached())
   {
-    m_search_thread.join();
+    m_abort_search = true;
   }
-  std::cout << "bestmove " << m_move_gen.move_to_long_algebraic(get_best_move()) << std::endl;
 }
 
-void Searcher::find_best_move_timed(int time)
+void SearchWorker::update_pv(int ply_from_root, Move move)
 {
-  ponder();
-  std::this_thread::sleep_for(std::chrono::milliseconds(time));
-  stop();
+  m_pv[ply_from_root][ply_from_root] = move;
+  for (int ply = ply_from_root + 1; ply < m_pv_length[ply_from_root + 1]; ply++)
+  {
+    m_pv[ply_from_root][ply] = m_pv[ply_from_root + 1][ply];
+  }
+  m_pv_length[ply_from_root] = m_pv_length[ply_from_root + 1];
 }
 
-int Searcher::qsearch(int alpha, int beta)
+int SearchWorker::qsearch(int ply_from_root, int alpha, int beta)
 {
-  std::vector<Move> captures;
-  uint64_t h = m_board->get_hash();
+  count_node();
+  m_seldepth = std::max(m_seldepth, ply_from_root);
 
   /**
    * Since none of these captures are forced, meaning a player doesn't
@@ -149,15 +604,15 @@ int Searcher::qsearch(int alpha, int beta)
   if(stand_pat >= beta) return beta;
   if(alpha < stand_pat) alpha = stand_pat;
 
-  m_move_gen.generate_moves(captures, true); // true flag generates only captures
-  m_move_gen.order_moves(captures); /* I could make an order capture functions that I call here to not waste time */
-  for (Move& capture : captures) {
+  MovePicker picker{m_move_gen};
+  Move capture;
+  while (!(capture = picker.next_move()).is_no_move()) {
     /* delta pruning helps to stop searching helpless nodes */
     // piece captured_piece = b.sq_board[TO(capture)];
-    if(m_move_gen.is_bad_capture(capture)) /* don't consider captures that are bad */
+    if(!m_move_gen.see_ge(capture, constants::QSEARCH_SEE_THRESHOLD)) /* don't consider captures that lose material */
       continue;
     m_board->make_move(capture);
-    int evaluation = -qsearch(-beta, -alpha);
+    int evaluation = -qsearch(ply_from_root + 1, -beta, -alpha);
     m_board->unmake_move(capture);
 
     if(evaluation >= beta) return beta;
@@ -166,18 +621,28 @@ int Searcher::qsearch(int alpha, int beta)
   return alpha;
 }
 
-int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_pv, bool can_null)
+int SearchWorker::search(int ply_from_root, int depth, int alpha, int beta, bool is_pv, bool can_null)
 {
+  check_time();
   if (m_abort_search)
   {
     return 0;
   }
 
+  m_pv_length[ply_from_root] = ply_from_root; // no line from here until a move raises alpha
+  m_seldepth = std::max(m_seldepth, ply_from_root); // counted before any early return, so the pv line always reaches depth
+  if (ply_from_root >= constants::MAX_PLY - 1)
+  {
+    return m_evaluator.evaluate(alpha, beta); // the pv table can't go any deeper
+  }
+
   TranspositionTable::Flags flags = TranspositionTable::ALPHA;
   uint64_t h = m_board->get_hash();
   if (ply_from_root > 0)
   {
-    std::optional<int> tt_score = m_tt.fetch_score(h, depth, ply_from_root, alpha, beta);
+    /* nodes with an open window are always searched, a tt cutoff there would leave the reported line ending at this node */
+    bool open_window = (int64_t)beta - alpha > 1; // the full window is INT_MAX wide, too wide for an int
+    std::optional<int> tt_score = open_window ? std::nullopt : m_tt.fetch_score(h, depth, ply_from_root, alpha, beta);
     if (tt_score)
     {
       return tt_score.value();
@@ -191,11 +656,12 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
 
   if (depth == 0) 
   {
-    return qsearch(alpha, beta);
+    return qsearch(ply_from_root, alpha, beta);
   }
+  count_node();
 
   // if we just made a null move (passed the turn), we cannot be in check
-  bool check_flag = can_null ? m_move_gen.in_check() : false;
+  bool check_flag = can_null ? m_board->in_check() : false;
 
   /* check extension */
   if (check_flag)
@@ -226,6 +692,7 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
     m_board->make_nullmove();
     int score = -search(ply_from_root, depth - reduce - 1, -beta, -beta + 1, false, false);
     m_board->unmake_nullmove();
+    m_pv_length[ply_from_root] = ply_from_root; // the null move search used this ply's line as well
 
     if (m_abort_search)
     {
@@ -239,18 +706,54 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
     }
   }
 
-  std::vector<Move> moves;
-  m_move_gen.generate_moves(moves);
-  m_move_gen.order_moves(moves, (ply_from_root == 0) ? m_best_move : m_tt.fetch_best_move(h), std::make_optional<int>(ply_from_root)); // search the best move if in the top position
+  /*
+    Futility Pruning:
+      - Close to the horizon, a quiet move is very unlikely to make up a big material deficit.
+      - If the static eval plus a margin can't even reach alpha, quiet moves that don't give
+      check are skipped instead of searched.
+  */
+  bool can_prune = !is_pv && !check_flag && ply_from_root > 0 && !utils::is_mate_score(alpha) && !utils::is_mate_score(beta);
+  bool futile = false;
+  if (can_prune && depth <= constants::FUTILITY_MAX_DEPTH)
+  {
+    futile = m_evaluator.evaluate(alpha, beta) + constants::futility_margins[depth] <= alpha;
+  }
+
+  /* search the best move if in the top position */
+  MovePicker picker{m_move_gen, (ply_from_root == 0) ? m_best_move : m_tt.fetch_best_move(h), ply_from_root};
   
   Move best_move_this_search;
+  Move move;
   int evaluation;
   bool pv_search = true;
+  int moves_searched = 0;
+  int legal_moves = 0;
+  MoveList quiets_searched; // penalized in the history if another quiet move causes the cutoff
   
-  for (const auto& move : moves) 
+  while (!(move = picker.next_move()).is_no_move()) 
   {
+    legal_moves++;
+    bool quiet = !move.is_capture() && !move.is_promo();
+    int history = quiet ? m_move_gen.get_history(move) : 0;
     bool pawn_extension = m_move_gen.pawn_promo_or_close_push(move);
     m_board->make_move(move);
+    bool gives_check = m_board->in_check();
+
+    if (quiet && !gives_check && !pv_search && !pawn_extension && can_prune)
+    {
+      /*
+        Late Move Pruning:
+          - With good ordering, a cutoff at a shallow node almost always comes from one of the
+          first few moves, so the quiet moves after them aren't searched at all.
+      */
+      bool late = depth <= constants::LMP_MAX_DEPTH && moves_searched >= 3 + depth * depth;
+      if (futile || late)
+      {
+        m_board->unmake_move(move);
+        continue;
+      }
+    }
+
     /*
       Principal Variation Search (PVS):
         - There is only one pathway of moves that are acceptable for both players in any given search.
@@ -265,8 +768,32 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
     }
     else 
     {
-      evaluation = -search(ply_from_root + 1, depth - 1 + pawn_extension, -alpha - 1, -alpha, false, true);
-      if (evaluation > alpha) 
+      /*
+        Late Move Reductions (LMR):
+          - Moves ordered late are rarely best, so quiet ones are first searched to a reduced depth
+          with a null window, and only searched fully if they surprise us by beating alpha.
+          - Moves with a good history are reduced less, moves with a bad one more.
+      */
+      int reduction = 0;
+      if (quiet && 
+          !gives_check && 
+          !check_flag && 
+          !pawn_extension && 
+          depth >= constants::LMR_MIN_DEPTH && 
+          moves_searched >= constants::LMR_MIN_MOVES)
+      {
+        reduction = lmr_reductions[std::min(depth, 63)][std::min(moves_searched, 63)];
+        reduction -= is_pv;
+        reduction -= history / constants::LMR_HISTORY_DIVISOR;
+        reduction = std::clamp(reduction, 0, depth - 2); // always leave at least a ply before qsearch
+      }
+
+      evaluation = -search(ply_from_root + 1, depth - 1 - reduction, -alpha - 1, -alpha, false, true);
+      if (reduction > 0 && evaluation > alpha)
+      {
+        evaluation = -search(ply_from_root + 1, depth - 1 + pawn_extension, -alpha - 1, -alpha, false, true);
+      }
+      if (evaluation > alpha && evaluation < beta) 
       {
         evaluation = -search(ply_from_root + 1, depth - 1 + pawn_extension, -beta, -alpha, true, true);
       }
@@ -281,7 +808,17 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
     
     if (evaluation >= beta) 
     {
-      m_move_gen.insert_killer(ply_from_root, move);
+      /* at the root this is an aspiration window fail high, the move is still better than anything before it */
+      if (ply_from_root == 0)
+      {
+        m_best_move_this_iteration = move;
+        m_best_score_this_iteration = beta;
+        update_pv(ply_from_root, move);
+      }
+      if (quiet)
+      {
+        m_move_gen.update_quiet_histories(ply_from_root, move, quiets_searched, depth);
+      }
       m_tt.store(h, depth, ply_from_root, TranspositionTable::BETA, beta, move); 
       return beta;
     }
@@ -291,6 +828,7 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
       flags = TranspositionTable::EXACT;
       alpha = evaluation;
       best_move_this_search = move;
+      update_pv(ply_from_root, move);
       /* if we are at the root node, replace the best move we've seen so far */
       if (ply_from_root == 0)
       {
@@ -298,10 +836,15 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
         m_best_score_this_iteration = evaluation;
       }
     }
+    if (quiet)
+    {
+      quiets_searched.push_back(move);
+    }
     pv_search = false;
+    moves_searched++;
   }
 
-  if (moves.empty()) 
+  if (legal_moves == 0) 
   {
     if (check_flag) 
     { /* checkmate */
@@ -319,13 +862,3 @@ int Searcher::search(int ply_from_root, int depth, int alpha, int beta, bool is_
   m_tt.store(h, depth, ply_from_root, flags, alpha, best_move_this_search);
   return alpha;
 }
-
-void Searcher::abort_search()
-{
-  m_abort_search = true;
-}
-
-Move Searcher::get_best_move()
-{
-  return m_best_move;
-}
\ No newline at end of file
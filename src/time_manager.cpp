@@ -0,0 +1,67 @@
+#include "include/time_manager.h"
+#include "include/constants.h"
+
+#include <algorithm>
+#include <chrono>
+
+void TimeManager::start(const Limits& limits)
+{
+  m_start = std::chrono::steady_clock::now();
+  m_best_move_changes = 0;
+  m_use_clock = false;
+  m_limited = true;
+
+  if (limits.move_time > 0)
+  {
+    /* think for exactly as long as we were told to */
+    m_soft_limit = m_hard_limit = std::max(limits.move_time - constants::MOVE_OVERHEAD, 1);
+  }
+  else if (limits.time_left > 0)
+  {
+    m_use_clock = true;
+    int64_t usable = std::max(limits.time_left - constants::MOVE_OVERHEAD, 1);
+    int64_t moves_to_go = (limits.moves_to_go > 0) ? std::min(limits.moves_to_go, constants::MAX_MOVES_TO_GO) : constants::DEFAULT_MOVES_TO_GO;
+
+    /* spread the remaining time evenly over the moves left, and spend most of the increment now */
+    m_soft_limit = usable / moves_to_go + limits.increment * 3 / 4;
+    /* never bet more than a few moves worth of time, or most of what's left, on a single move */
+    m_hard_limit = std::max<int64_t>(std::min(m_soft_limit * 4, usable * 3 / 4), 1);
+    m_soft_limit = std::min(m_soft_limit, m_hard_limit);
+  }
+  else
+  {
+    m_limited = false;
+  }
+}
+
+void TimeManager::iteration_finished(bool best_move_changed)
+{
+  m_best_move_changes = m_best_move_changes / 2 + (best_move_changed ? 1 : 0);
+}
+
+bool TimeManager::should_stop(int64_t last_iteration_ms) const
+{
+  if (!m_use_clock)
+  {
+    return false; /* infinite and fixed movetime searches run until they are stopped */
+  }
+  int64_t time_used = elapsed();
+  /* give ourselves up to ~3x the soft limit when the best move keeps changing */
+  double scale = 1.0 + m_best_move_changes;
+  if (time_used >= m_soft_limit * scale)
+  {
+    return true;
+  }
+  /* each ply takes at least about twice as long as the last, don't start one we can't finish */
+  return time_used + 2 * last_iteration_ms > m_hard_limit;
+}
+
+bool TimeManager::hard_limit_reached() const
+{
+  return m_limited && elapsed() >= m_hard_limit;
+}
+
+int64_t TimeManager::elapsed() const
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
@@ -7,6 +7,16 @@
 #include <cstdlib>
 #include <memory.h>
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <string>
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 int TranspositionTable::correct_retrieved_mate_score(int score, int ply_searched) 
 {
@@ -28,32 +38,90 @@ int TranspositionTable::correct_stored_mate_score(int score, int ply_searched)
   return score;
 }
 
-TranspositionTable::TranspositionTable(size_t entries) : m_entries(entries)
+TranspositionTable::TranspositionTable(size_t megabytes) : m_table{nullptr}, m_buckets{0}, m_age{0}
+{
+  resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+  /* the number of buckets has to be a power of two so we can index with a mask */
+  size_t bytes = std::max<size_t>(megabytes, 1) * 1024 * 1024;
+  m_buckets = 1;
+  while (m_buckets * 2 * sizeof(Bucket) <= bytes)
+  {
+    m_buckets *= 2;
+  }
+  /* anonymous mappings are zeroed lazily, so untouched parts of a big table cost nothing */
+  m_table = static_cast<Bucket*>(m_memory.allocate(sizeof(Bucket) * m_buckets));
+  m_age = 0;
+}
+
+void TranspositionTable::clear(size_t threads)
+{
+  threads = std::clamp<size_t>(threads, 1, m_buckets);
+  size_t slice = m_buckets / threads;
+
+  /* every thread zeroes its own slice, the last one also takes whatever doesn't divide evenly */
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < threads; i++)
+  {
+    size_t begin = i * slice;
+    size_t end = (i == threads - 1) ? m_buckets : begin + slice;
+    workers.emplace_back([this, begin, end]() {
+      memset((void *)(m_table + begin), 0, sizeof(Bucket) * (end - begin));
+    });
+  }
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+  m_age = 0;
+}
+
+void TranspositionTable::new_search()
 {
-  m_table = (Entry *)calloc(sizeof(Entry), entries);
+  m_age = (m_age + 1) & AGE_MASK;
 }
 
-TranspositionTable::~TranspositionTable()
+uint64_t TranspositionTable::pack(int depth, Flags flags, int score, Move best_move) const
 {
-  free(m_table);
+  depth = std::clamp(depth, 0, (int)DEPTH_MASK);
+  return ((uint64_t)best_move.get_move() & MOVE_MASK) | 
+         ((uint64_t)depth << DEPTH_OFFSET) | 
+         (((uint64_t)flags & FLAGS_MASK) << FLAGS_OFFSET) | 
+         ((uint64_t)m_age << AGE_OFFSET) | 
+         ((uint64_t)(uint32_t)score << SCORE_OFFSET);
 }
 
-void TranspositionTable::clear()
+std::optional<uint64_t> TranspositionTable::probe(uint64_t hash) const
 {
-  memset(m_table, 0, sizeof(Entry) * m_entries);
+  Bucket& bucket = m_table[hash & (m_buckets - 1)];
+  for (Entry& entry : bucket.entries)
+  {
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    if ((entry.key.load(std::memory_order_relaxed) ^ data) == hash)
+    {
+      return std::make_optional(data);
+    }
+  }
+  return std::nullopt;
 }
 
 std::optional<int> TranspositionTable::fetch_score(uint64_t hash, int depth, int ply_searched, int alpha, int beta)
 {
-  Entry entry = m_table[hash & (m_entries - 1)];
-  if (entry.key == hash && entry.depth >= depth) 
+  std::optional<uint64_t> data = probe(hash);
+  if (data && get_depth(*data) >= depth) 
   {
-    int corrected_score = correct_retrieved_mate_score(entry.score, ply_searched);
-    if (entry.flags == EXACT)
+    int corrected_score = correct_retrieved_mate_score(get_score(*data), ply_searched);
+    Flags flags = get_flags(*data);
+    if (flags == EXACT)
       return std::make_optional(corrected_score);
-    if (entry.flags == ALPHA && corrected_score <= alpha)
+    if (flags == ALPHA && corrected_score <= alpha)
       return std::make_optional(alpha);
-    if (entry.flags == BETA && corrected_score >= beta)
+    if (flags == BETA && corrected_score >= beta)
       return std::make_optional(beta);
   }
   return std::nullopt;
@@ -61,52 +129,150 @@ std::optional<int> TranspositionTable::fetch_score(uint64_t hash, int depth, int
 
 Move TranspositionTable::fetch_best_move(uint64_t hash)
 {
-  Entry entry = m_table[hash & (m_entries - 1)];
-  if (entry.key == hash)
+  std::optional<uint64_t> data = probe(hash);
+  if (data)
   {
-    return entry.best_move;
+    return get_move(*data);
   }
   return Move::NO_MOVE;
 }
 
-std::optional<int> TranspositionTable::fetch_score(uint64_t hash, int alpha, int beta)
+void TranspositionTable::store(uint64_t hash, int depth, int ply_searched, Flags flags, int score, Move best_move)
 {
-  Entry entry = m_table[hash & (m_entries - 1)];
-  if(entry.key == hash) 
+  int corrected_score = correct_stored_mate_score(score, ply_searched);
+  Bucket& bucket = m_table[hash & (m_buckets - 1)];
+
+  /**
+   * Overwrite this position if it is already in the bucket, otherwise replace the
+   * least valuable entry. Shallow entries from old searches are worth the least.
+   */
+  Entry* replace = &bucket.entries[0];
+  int replace_worth = INT_MAX;
+  uint64_t replace_data = 0;
+  bool same_position = false;
+  for (Entry& entry : bucket.entries)
   {
-    int score = entry.score;
-    if(entry.flags == EXACT)
-      return std::make_optional(score);
-    if(entry.flags == ALPHA && score <= alpha)
-      return std::make_optional(alpha);
-    if(entry.flags == BETA && score >= beta)
-      return std::make_optional(beta);
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t key = entry.key.load(std::memory_order_relaxed) ^ data;
+    if (key == hash)
+    {
+      replace = &entry;
+      replace_data = data;
+      same_position = true;
+      break;
+    }
+    int relative_age = (m_age - get_age(data)) & AGE_MASK;
+    int worth = (key == 0) ? INT_MIN : get_depth(data) - 8 * relative_age;
+    if (worth < replace_worth)
+    {
+      replace = &entry;
+      replace_worth = worth;
+      replace_data = data;
+    }
   }
-  return std::nullopt;
+
+  if (same_position)
+  {
+    /* don't lose the best move because we got here through a null move cutoff */
+    if (best_move.is_no_move())
+    {
+      best_move = get_move(replace_data);
+    }
+    /* a much deeper bound from this search is worth more than a shallow one */
+    if (flags != EXACT && get_age(replace_data) == m_age && depth + 2 < get_depth(replace_data))
+    {
+      return;
+    }
+  }
+
+  uint64_t data = pack(depth, flags, corrected_score, best_move);
+  replace->key.store(hash ^ data, std::memory_order_relaxed);
+  replace->data.store(data, std::memory_order_relaxed);
 }
 
-void TranspositionTable::store(uint64_t hash, int depth, int ply_searched, Flags flags, int score, Move best_move)
+bool TranspositionTable::save(const std::string& path) const
 {
-  int corrected_score = correct_stored_mate_score(score, ply_searched);
-  Entry* entry = &m_table[hash & (m_entries - 1)];
-  entry->key ? m_overwrites++ : m_filled_entries++;
-  entry->key = hash;
-  entry->depth = depth;
-  entry->flags = flags;
-  entry->score = corrected_score;
-  entry->best_move = best_move;
+  /* 
+    A loaded table is a private mapping of its snapshot, so writing over that file in place would pull
+    the pages out from under us. Write a new file and rename it over the old one instead, the mapping
+    keeps the old file alive until it is released.
+  */
+  std::string tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+
+  SnapshotHeader header{};
+  std::copy(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), header.magic);
+  header.version = SNAPSHOT_VERSION;
+  header.zobrist_seed = Hasher::ZOBRIST_SEED;
+  header.zobrist_checksum = Hasher{}.get_checksum();
+  header.bucket_bytes = sizeof(Bucket);
+  header.entries_per_bucket = BUCKET_SIZE;
+  header.buckets = m_buckets;
+  header.age = m_age;
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(m_table), sizeof(Bucket) * m_buckets);
+  file.close();
+  if (!file || std::rename(tmp_path.c_str(), path.c_str()) != 0)
+  {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
 }
 
-void TranspositionTable::store(uint64_t hash, Flags flags, int score)
+bool TranspositionTable::load(const std::string& path)
 {
-  Entry* entry = &m_table[hash & (m_entries - 1)];
-  entry->key = hash;
-  entry->score = score;
-  entry->flags = flags;
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  SnapshotHeader header{};
+  struct stat st;
+  bool valid = fstat(fd, &st) == 0 && 
+               pread(fd, &header, sizeof(header), 0) == sizeof(header) && 
+               std::equal(std::begin(SNAPSHOT_MAGIC), std::end(SNAPSHOT_MAGIC), header.magic) &&
+               header.version == SNAPSHOT_VERSION &&
+               header.zobrist_seed == Hasher::ZOBRIST_SEED &&
+               header.zobrist_checksum == Hasher{}.get_checksum() &&
+               header.bucket_bytes == sizeof(Bucket) && 
+               header.entries_per_bucket == BUCKET_SIZE &&
+               header.buckets != 0 && (header.buckets & (header.buckets - 1)) == 0 && // indexed with a mask
+               (uint64_t)st.st_size == sizeof(header) + sizeof(Bucket) * header.buckets;
+  
+  char* memory = valid ? static_cast<char*>(m_memory.map_file(fd, st.st_size)) : nullptr;
+  close(fd); // the mapping keeps the file alive
+  if (!memory)
+  {
+    return false; // the old table is only released once the new one is mapped
+  }
+  m_table = reinterpret_cast<Bucket*>(memory + sizeof(SnapshotHeader));
+  m_buckets = header.buckets;
+  m_age = header.age;
+  return true;
 }
 
 double TranspositionTable::get_occupancy()
 {
-  return (double) m_filled_entries / (double) m_entries;
+  /* sample the start of the table instead of keeping shared counters up to date */
+  size_t samples = std::min<size_t>(m_buckets, 1000);
+  size_t filled = 0;
+  for (size_t i = 0; i < samples; i++)
+  {
+    for (Entry& entry : m_table[i].entries)
+    {
+      uint64_t data = entry.data.load(std::memory_order_relaxed);
+      if ((entry.key.load(std::memory_order_relaxed) ^ data) != 0 && get_age(data) == m_age)
+      {
+        filled++;
+      }
+    }
+  }
+  return (double) filled / (double) (samples * BUCKET_SIZE);
 }
-
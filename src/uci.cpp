@@ -1,6 +1,7 @@
 #include <iostream>
 #include <thread>
 #include <string>
+#include <chrono>
 #include <bits/stdc++.h> 
 
 #include "include/uci.h"
@@ -8,6 +9,7 @@
 #include "include/board.h"
 #include "include/move.h"
 #include "include/tt.h"
+#include "include/openings.h"
 #include "include/utils.h"
 
 /// TODO: make it so commands at the wrong time don't work
@@ -35,6 +37,10 @@ void UCICommunicator::start_uci_communication()
     {
       handle_is_ready();
     }
+    else if (main_cmd == SETOPTION)
+    {
+      handle_set_option(cmd_list);
+    }
     else if (main_cmd == UCINEWGAME)
     {
       handle_new_game();
@@ -54,6 +60,7 @@ void UCICommunicator::start_uci_communication()
     else if (main_cmd == QUIT)
     {
       handle_quit(); 
+      return;
     }
     else if (main_cmd == VERIFY)
     {
@@ -63,6 +70,22 @@ void UCICommunicator::start_uci_communication()
     {
       handle_show();
     }
+    else if (main_cmd == BENCH)
+    {
+      handle_bench(cmd_list);
+    }
+    else if (main_cmd == COMPILEBOOK)
+    {
+      handle_compile_book(cmd_list);
+    }
+    else if (main_cmd == SAVEHASH)
+    {
+      handle_save_hash(cmd_list);
+    }
+    else if (main_cmd == LOADHASH)
+    {
+      handle_load_hash(cmd_list);
+    }
   }
 }
 
@@ -71,6 +94,13 @@ void UCICommunicator::handle_uci()
   /// TODO: add option command in here to give engine options 
   std::cout << ID_NAME;
   std::cout << ID_AUTHOR;
+  std::cout << OPTION_THREADS;
+  std::cout << OPTION_HASH;
+  std::cout << OPTION_EVALHASH;
+  std::cout << OPTION_PAWNHASH;
+  std::cout << OPTION_BOOKFILE;
+  std::cout << OPTION_BOOKBESTMOVE;
+  std::cout << "info string " << m_searcher.get_memory_info() << std::endl;
   std::cout << UCIOK;
 }
 
@@ -79,9 +109,68 @@ void UCICommunicator::handle_is_ready()
   std::cout << READYOK;
 }
 
+/// TODO: option names with spaces in them aren't supported
+void UCICommunicator::handle_set_option(std::vector<std::string>& parsed_cmd)
+{
+  auto name_pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), NAME);
+  auto value_pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), VALUE);
+  if (name_pos >= parsed_cmd.end() - 1 || value_pos >= parsed_cmd.end() - 1)
+  {
+    return;
+  }
+
+  std::string name = *(name_pos + 1);
+  std::string value = *(value_pos + 1);
+  try
+  {
+    apply_option(name, value);
+  }
+  catch (const std::logic_error&) /* stoi and friends throw invalid_argument or out_of_range */
+  {
+    std::cout << "info string invalid value " << value << " for " << name << std::endl;
+  }
+}
+
+void UCICommunicator::apply_option(const std::string& name, const std::string& value)
+{
+  if (name == THREADS)
+  {
+    m_searcher.set_threads(std::max(std::stoi(value), 1)); // clamped before it can turn into a huge size_t
+  }
+  else if (name == HASH)
+  {
+    m_searcher.set_hash_size(std::stoul(value));
+    std::cout << "info string " << m_searcher.get_memory_info() << std::endl;
+  }
+  else if (name == EVALHASH)
+  {
+    m_searcher.set_eval_table_sizes(std::stoul(value), m_searcher.get_pawn_hash_mb());
+    std::cout << "info string " << m_searcher.get_memory_info() << std::endl;
+  }
+  else if (name == PAWNHASH)
+  {
+    m_searcher.set_eval_table_sizes(m_searcher.get_eval_cache_mb(), std::stoul(value));
+    std::cout << "info string " << m_searcher.get_memory_info() << std::endl;
+  }
+  else if (name == BOOKFILE)
+  {
+    if (!m_searcher.set_book(value))
+    {
+      std::cout << "info string could not open book " << value << std::endl;
+    }
+  }
+  else if (name == BOOKBESTMOVE)
+  {
+    m_searcher.set_book_best_move(value == "true");
+  }
+}
+
 void UCICommunicator::handle_new_game()
 {
+  /* the search thread reads the shared board, so it has to be idle before we touch it */
+  m_searcher.halt();
   m_board->reset(); // probably not necessary
+  m_searcher.clear_tt(); /* nothing from the last game is worth keeping */
 }
 
 void UCICommunicator::handle_position(std::vector<std::string>& parsed_cmd, std::string& cmd)
@@ -117,6 +206,7 @@ void UCICommunicator::handle_position(std::vector<std::string>& parsed_cmd, std:
     long_algebraic_moves.push_back(*it);
   }
 
+  m_searcher.halt(); /* a new position makes any running search pointless */
   m_board->reset(fen);
 
   for (std::string algebraic_move : long_algebraic_moves)
@@ -131,7 +221,7 @@ void UCICommunicator::handle_go(std::vector<std::string>& parsed_cmd, std::strin
 {
   if (parsed_cmd.size() == 1 || parsed_cmd[1] == PONDER) 
   {
-    m_searcher.ponder();
+    m_searcher.start_search();
   } 
   else if (parsed_cmd[1] == PERFT)
   {
@@ -140,26 +230,41 @@ void UCICommunicator::handle_go(std::vector<std::string>& parsed_cmd, std::strin
       return;
     }
     int depth = std::stoi(parsed_cmd[2]);
-    m_searcher.perft(depth);
+    /* go perft <depth> [threads <n>], the Threads option by default */
+    size_t threads = m_searcher.get_threads();
+    if (parsed_cmd.size() > 4 && parsed_cmd[3] == PERFT_THREADS)
+    {
+      threads = std::stoi(parsed_cmd[4]);
+    }
+    m_searcher.perft(depth, threads);
   }
   else // handle the go case with more parameters
   {
-    auto move_time_pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), MOVETIME);
-    if (move_time_pos != parsed_cmd.end())
+    /* finds the integer argument following a keyword, if it was given */
+    auto find_arg = [&parsed_cmd](const std::string& keyword) -> std::optional<int>
     {
-      m_searcher.find_best_move_timed(std::stoi(*(move_time_pos + 1))); // find the movetime argument 
-      return;
-    }
-    
-    auto wtime_pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), WTIME);
-    auto btime_pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), BTIME);
-    if (wtime_pos != parsed_cmd.end() && btime_pos != parsed_cmd.end())
+      auto pos = std::find(parsed_cmd.begin(), parsed_cmd.end(), keyword);
+      if (pos >= parsed_cmd.end() - 1)
+      {
+        return std::nullopt;
+      }
+      return std::stoi(*(pos + 1));
+    };
+
+    if (std::find(parsed_cmd.begin(), parsed_cmd.end(), INFINITE) != parsed_cmd.end())
     {
-      int wtime = std::stoi(*(wtime_pos + 1));
-      int btime = std::stoi(*(btime_pos + 1));
-      int engine_time = m_board->is_white_turn() ? wtime : btime;
-      m_searcher.find_best_move_timed(1000); // for now just use 1 second for now
+      m_searcher.start_search();
+      return;
     }
+
+    bool white = m_board->is_white_turn();
+    TimeManager::Limits limits;
+    limits.move_time = find_arg(MOVETIME).value_or(0);
+    limits.time_left = find_arg(white ? WTIME : BTIME).value_or(0);
+    limits.increment = find_arg(white ? WINC : BINC).value_or(0);
+    limits.moves_to_go = find_arg(MOVESTOGO).value_or(0);
+    limits.depth = find_arg(DEPTH).value_or(INT_MAX);
+    m_searcher.start_search(limits);
   }
 }
 
@@ -178,6 +283,7 @@ void UCICommunicator::handle_verify(std::vector<std::string>& parsed_cmd)
   std::string test_pos_5 = "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8";
   std::string test_pos_6 = "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10";
 
+  m_searcher.halt(); /* these reset the shared board */
   m_board->reset(test_pos_1);
   std::cout << "Test 1 total: " << m_searcher.num_nodes_bulk(depth) << std::endl;
   m_board->reset(test_pos_2);
@@ -194,10 +300,101 @@ void UCICommunicator::handle_verify(std::vector<std::string>& parsed_cmd)
 
 void UCICommunicator::handle_quit()
 {
-  exit(0); /* quit successfully*/
+  /* let the search thread finish cleanly, start_uci_communication returns after this */
+  m_searcher.halt();
+}
+
+void UCICommunicator::handle_bench(std::vector<std::string>& parsed_cmd)
+{
+  int depth = parsed_cmd.size() > 1 ? std::stoi(parsed_cmd[1]) : 6; /* default */
+  size_t max_threads = parsed_cmd.size() > 2 ? std::stoi(parsed_cmd[2]) : std::thread::hardware_concurrency();
+  max_threads = std::max<size_t>(max_threads, 1);
+  size_t prev_threads = m_searcher.get_threads();
+
+  std::vector<std::string> positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+  };
+
+  /* time to depth for 1, 2, 4, ... threads, always finishing with max_threads */
+  double single_thread_ms = 0;
+  for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads))
+  {
+    m_searcher.set_threads(threads);
+    uint64_t nodes = 0;
+    double total_ms = 0;
+    for (std::string& fen : positions)
+    {
+      m_board->reset(fen);
+      m_searcher.clear_tt(); /* every thread count starts from an empty table */
+      auto begin = std::chrono::steady_clock::now();
+      TimeManager::Limits limits;
+      limits.depth = depth;
+      m_searcher.find_best_move(limits);
+      auto end = std::chrono::steady_clock::now();
+      total_ms += std::chrono::duration<double, std::milli>(end - begin).count();
+      nodes += m_searcher.get_nodes();
+    }
+
+    if (threads == 1)
+    {
+      single_thread_ms = total_ms;
+    }
+    std::cout << "threads " << threads 
+              << " depth " << depth 
+              << " time " << static_cast<uint64_t>(total_ms) 
+              << " nodes " << nodes 
+              << " nps " << static_cast<uint64_t>(nodes / (total_ms / 1000.0)) 
+              << " speedup " << single_thread_ms / total_ms << std::endl;
+
+    if (threads == max_threads)
+    {
+      break;
+    }
+  }
+  m_searcher.set_threads(prev_threads);
+}
+
+void UCICommunicator::handle_compile_book(std::vector<std::string>& parsed_cmd)
+{
+  std::string text_path = parsed_cmd.size() > 1 ? parsed_cmd[1] : "assets/opening_book.pgn"; /* default */
+  std::string book_path = parsed_cmd.size() > 2 ? parsed_cmd[2] : "assets/opening_book.cbook";
+  size_t entries = OpeningBook::compile(text_path, book_path);
+  std::cout << "wrote " << entries << " entries to " << book_path << std::endl;
+}
+
+void UCICommunicator::handle_save_hash(std::vector<std::string>& parsed_cmd)
+{
+  std::string path = parsed_cmd.size() > 1 ? parsed_cmd[1] : HASH_FILE;
+  if (m_searcher.save_tt(path))
+  {
+    std::cout << "info string saved hash to " << path << std::endl;
+  }
+  else
+  {
+    std::cout << "info string could not save hash to " << path << std::endl;
+  }
+}
+
+void UCICommunicator::handle_load_hash(std::vector<std::string>& parsed_cmd)
+{
+  std::string path = parsed_cmd.size() > 1 ? parsed_cmd[1] : HASH_FILE;
+  if (m_searcher.load_tt(path))
+  {
+    std::cout << "info string loaded hash from " << path << ", " << m_searcher.get_memory_info() << std::endl;
+  }
+  else
+  {
+    std::cout << "info string could not load hash from " << path << " (missing, or saved by an incompatible build)" << std::endl;
+  }
 }
 
 void UCICommunicator::handle_show()
 {
+  m_searcher.halt(); /* the board is only stable once the search thread is idle */
   std::cout << m_board->to_string();
 }
\ No newline at end of file